@@ -0,0 +1,110 @@
+#include "../Model/MooreMachine.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+struct Result
+{
+	double milliseconds;
+	size_t stateCount;
+	size_t minimizedStateCount;
+};
+
+// FromRegular, then GetDeterministic and GetMinimized for the NFA constructions. The derivative
+// DFA is timed without minimization, it is minimized afterwards only to count its states.
+Result Measure(const std::string& regular, const MooreMachine::RegularConstruction construction)
+{
+	const auto start = Clock::now();
+	MooreMachine moore;
+	moore.FromRegular(regular, construction);
+	if (construction == MooreMachine::RegularConstruction::DERIVATIVES)
+	{
+		const std::chrono::duration<double, std::milli> time = Clock::now() - start;
+		return { time.count(), moore.GetStates().size(), moore.GetMinimized()->GetStates().size() };
+	}
+	const auto min = moore.GetDeterministic()->GetMinimized();
+	const std::chrono::duration<double, std::milli> time = Clock::now() - start;
+	return { time.count(), min->GetStates().size(), min->GetStates().size() };
+}
+
+std::string MakeSuffixPattern(const size_t length)
+{
+	std::string regular = "(a|b)*a";
+	for (size_t i = 1; i < length; ++i)
+	{
+		regular += "(a|b)";
+	}
+	return regular;
+}
+
+std::string MakeDictionary(const size_t wordCount)
+{
+	std::mt19937 random(42);
+	std::string regular = "(a|b|c|d|f|g|h)*(";
+	for (size_t word = 0; word < wordCount; ++word)
+	{
+		regular += word > 0 ? "|" : "";
+		for (size_t length = 4 + random() % 5; length > 0; --length)
+		{
+			regular += "abcdfgh"[random() % 7];
+		}
+	}
+	return regular + ")";
+}
+} // namespace
+
+// Compiles regular expressions into minimal DFAs through the Thompson and the
+// Glushkov NFA, each followed by GetDeterministic and GetMinimized, and
+// straight into a DFA through Brzozowski derivatives.
+// Usage: RegularBenchmark [regular...]
+int main(int argc, char* argv[])
+{
+	try
+	{
+		std::vector<std::string> regulars(argv + 1, argv + argc);
+		if (regulars.empty())
+		{
+			regulars = {
+				"((a*(a|b)*a) | b* (c|b)* b | c* (c|a)* c)",
+				"((a|b)*c(a|b)*d)*(a|b|c|d)*abcd(a|b)*",
+				MakeSuffixPattern(10),
+				MakeSuffixPattern(14),
+				MakeDictionary(200),
+				MakeDictionary(1000),
+			};
+		}
+
+		std::cout << std::fixed << std::setprecision(2);
+		for (const auto& regular : regulars)
+		{
+			const auto thompson = Measure(regular, MooreMachine::RegularConstruction::THOMPSON);
+			const auto glushkov = Measure(regular, MooreMachine::RegularConstruction::GLUSHKOV);
+			const auto derivatives = Measure(regular, MooreMachine::RegularConstruction::DERIVATIVES);
+			if (thompson.stateCount != glushkov.stateCount || thompson.stateCount != derivatives.minimizedStateCount)
+			{
+				throw std::runtime_error("Minimal DFAs differ for " + regular);
+			}
+
+			std::cout << (regular.size() > 60 ? regular.substr(0, 57) + "..." : regular) << std::endl;
+			std::cout << "  Thompson + det + min: " << std::setw(10) << thompson.milliseconds << " ms, "
+					  << thompson.stateCount << " states" << std::endl;
+			std::cout << "  Glushkov + det + min: " << std::setw(10) << glushkov.milliseconds << " ms, "
+					  << glushkov.stateCount << " states" << std::endl;
+			std::cout << "  Derivatives:          " << std::setw(10) << derivatives.milliseconds << " ms, "
+					  << derivatives.stateCount << " states" << std::endl;
+		}
+	}
+	catch (const std::exception& exception)
+	{
+		std::cout << exception.what() << std::endl;
+		return 1;
+	}
+}
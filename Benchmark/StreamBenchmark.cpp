@@ -0,0 +1,91 @@
+#include "../Model/MooreMachine.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Classifies many short random sequences with a random complete Moore DFA,
+// once stream by stream with Run, once interleaved with RunStreams and once
+// with the executor, which switches to byte shuffles for up to 16 states.
+// Usage: StreamBenchmark [states] [streams] [length]
+int main(int argc, char* argv[])
+{
+	try
+	{
+		const size_t stateCount = argc > 1 ? std::stoul(argv[1]) : 1 << 18;
+		const size_t streamCount = argc > 2 ? std::stoul(argv[2]) : 1 << 20;
+		const size_t length = argc > 3 ? std::stoul(argv[3]) : 32;
+		const size_t inputCount = 4;
+
+		std::mt19937 random(42);
+		MooreMachine moore("S0");
+		for (size_t state = 0; state < stateCount; ++state)
+		{
+			moore.AddStateOutput("S" + std::to_string(state), std::to_string(random() % 2));
+		}
+		for (size_t state = 0; state < stateCount; ++state)
+		{
+			for (size_t input = 0; input < inputCount; ++input)
+			{
+				moore.AddTransition("S" + std::to_string(state), "x" + std::to_string(input), "S" + std::to_string(random() % stateCount));
+			}
+		}
+		const auto table = moore.Compile();
+		const auto executor = moore.CompileExecutor();
+
+		std::vector<TransitionTable::Id> inputs(streamCount * length);
+		for (auto& input : inputs)
+		{
+			input = static_cast<TransitionTable::Id>(random() % inputCount);
+		}
+		std::vector<std::span<const TransitionTable::Id>> streams;
+		for (size_t stream = 0; stream < streamCount; ++stream)
+		{
+			streams.emplace_back(inputs.data() + stream * length, length);
+		}
+
+		using Clock = std::chrono::steady_clock;
+		std::vector<TransitionTable::RunResult> single(streamCount);
+		auto start = Clock::now();
+		for (size_t stream = 0; stream < streamCount; ++stream)
+		{
+			single[stream] = table.Run(table.GetInitialState(), streams[stream], {});
+		}
+		const std::chrono::duration<double> singleTime = Clock::now() - start;
+
+		std::vector<TransitionTable::RunResult> interleaved(streamCount);
+		start = Clock::now();
+		table.RunStreams(table.GetInitialState(), streams, interleaved);
+		const std::chrono::duration<double> interleavedTime = Clock::now() - start;
+
+		std::vector<TransitionTable::RunResult> executed(streamCount);
+		start = Clock::now();
+		executor.RunStreams(table.GetInitialState(), streams, executed);
+		const std::chrono::duration<double> executorTime = Clock::now() - start;
+
+		size_t accepted = 0;
+		for (size_t stream = 0; stream < streamCount; ++stream)
+		{
+			if (single[stream].state != interleaved[stream].state || single[stream].state != executed[stream].state)
+			{
+				throw std::runtime_error("Results differ for stream " + std::to_string(stream));
+			}
+			accepted += moore.GetOutputs()[table.GetStateOutput(single[stream].state)] == "1";
+		}
+
+		const double symbols = static_cast<double>(inputs.size());
+		std::cout << stateCount << " states, " << streamCount << " streams of " << length << " inputs, "
+				  << accepted << " end in output 1" << std::endl;
+		std::cout << "Run:        " << symbols / singleTime.count() / 1e6 << " M inputs/s" << std::endl;
+		std::cout << "RunStreams: " << symbols / interleavedTime.count() / 1e6 << " M inputs/s" << std::endl;
+		std::cout << "Executor:   " << symbols / executorTime.count() / 1e6 << " M inputs/s"
+				  << (executor.UsesShuffles() ? " (shuffles)" : " (table)") << std::endl;
+	}
+	catch (const std::exception& exception)
+	{
+		std::cout << exception.what() << std::endl;
+		return 1;
+	}
+}
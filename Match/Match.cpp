@@ -0,0 +1,539 @@
+#include "../Model/MappedFile.h"
+#include "../Model/MooreMachine.h"
+#include "../Model/RequiredInputs.h"
+#include "../Model/ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+// Input every byte outside the alphabet of the expression is read as.
+const std::string OTHER_INPUT = "other";
+// Big files are split into pieces of about this size so they spread over the threads.
+constexpr size_t CHUNK_SIZE = 4 << 20;
+// Files mapped at once, the output of a batch is printed before the next one is mapped.
+constexpr size_t BATCH_FILES = 64;
+// Larger first byte sets match too many lines for the byte scan to pay off.
+constexpr size_t MAX_FIRST_BYTES = 16;
+
+struct Options
+{
+	bool count = false;
+	bool byteOffset = false;
+	bool stats = false;
+	size_t threadCount = 0;
+	// The expression, or the lines of the -f file, all matched in one scan.
+	std::vector<std::string> patterns;
+	std::vector<std::string> fileNames;
+};
+
+enum class Prefilter
+{
+	NONE,
+	LITERAL,
+	FIRST_BYTES,
+};
+
+// DFA with one column per byte value, a line matches once a step enters an accepting state.
+// Lines without the literal, or without any of the first bytes, cannot match and are skipped.
+// Expressions whose repetitions unroll too far run on a counting automaton instead of the DFA.
+struct ByteMatcher
+{
+	std::optional<CountingAutomaton> counting;
+	std::vector<TransitionTable::Id> next;
+	std::vector<char> accepting;
+	TransitionTable::Id initialState = 0;
+	Prefilter prefilter = Prefilter::NONE;
+	std::string literal;
+	std::array<char, 256> isFirstByte{};
+	std::string firstBytes;
+};
+
+struct Job
+{
+	size_t file;
+	size_t begin;
+	size_t end;
+	size_t count = 0;
+	// Lines the prefilter let through to the DFA.
+	size_t candidates = 0;
+	size_t scannedBytes = 0;
+	std::string text;
+};
+
+void PrintUsage()
+{
+	std::cerr << "Usage: Match [-c|--count] [-b|--byte-offset] [-s|--stats] [-j|--threads N] "
+				 "(<regular expression> | -f|--file <pattern file>) [file...]"
+			  << std::endl;
+	std::cerr << "Prints the lines containing a match, reads stdin when no file or \"-\" is given." << std::endl;
+	std::cerr << "--file takes one expression per line and prints the lines matching any of them." << std::endl;
+	std::cerr << "--stats prints the prefilter and how many of the lines it let through matched to stderr." << std::endl;
+}
+
+std::vector<std::string> ReadPatterns(const std::string& fileName)
+{
+	std::ifstream file(fileName);
+	if (!file)
+	{
+		throw std::runtime_error("Cannot open pattern file: " + fileName);
+	}
+	std::vector<std::string> patterns;
+	for (std::string line; std::getline(file, line);)
+	{
+		if (!line.empty())
+		{
+			patterns.push_back(line);
+		}
+	}
+	if (patterns.empty())
+	{
+		throw std::runtime_error("No patterns in " + fileName);
+	}
+	return patterns;
+}
+
+Options ParseOptions(const int argc, char* argv[])
+{
+	Options options;
+	bool hasRegular = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		if (argument == "-c" || argument == "--count")
+		{
+			options.count = true;
+		}
+		else if (argument == "-b" || argument == "--byte-offset")
+		{
+			options.byteOffset = true;
+		}
+		else if (argument == "-s" || argument == "--stats")
+		{
+			options.stats = true;
+		}
+		else if ((argument == "-j" || argument == "--threads") && i + 1 < argc)
+		{
+			options.threadCount = std::stoul(argv[++i]);
+		}
+		else if ((argument == "-f" || argument == "--file") && i + 1 < argc && !hasRegular)
+		{
+			options.patterns = ReadPatterns(argv[++i]);
+			hasRegular = true;
+		}
+		else if (!hasRegular)
+		{
+			options.patterns = { argument };
+			hasRegular = true;
+		}
+		else
+		{
+			options.fileNames.push_back(argument);
+		}
+	}
+	if (!hasRegular)
+	{
+		throw std::invalid_argument("Missing regular expression.");
+	}
+	if (options.fileNames.empty())
+	{
+		options.fileNames.emplace_back("-");
+	}
+	return options;
+}
+
+// Escapes the spaces FromRegular would ignore, so they match like the other characters, as in grep.
+std::string EscapeSpaces(const std::string_view pattern)
+{
+	std::string escaped;
+	for (size_t i = 0; i < pattern.size(); ++i)
+	{
+		if (pattern[i] == ' ')
+		{
+			escaped += '\\';
+		}
+		else if (pattern[i] == '\\' && i + 1 < pattern.size())
+		{
+			escaped += pattern[i++];
+		}
+		escaped += pattern[i];
+	}
+	return escaped;
+}
+
+std::vector<char> GetAccepting(const Machine& machine, const TransitionTable& table)
+{
+	std::vector<char> accepting(table.GetStateCount());
+	for (TransitionTable::Id state = 0; state < table.GetStateCount(); ++state)
+	{
+		// A single expression accepts with "1", several with a non-empty set of patterns.
+		const auto& output = machine.GetOutputs()[table.GetStateOutput(state)];
+		accepting[state] = output == "1" || !MooreMachine::GetMatchedPatterns(output).empty();
+	}
+	return accepting;
+}
+
+// Finds what every match contains on the minimal DFA of the expression alone.
+void AddPrefilter(const MooreMachine& nfa, ByteMatcher& matcher)
+{
+	const auto dfa = nfa.GetDeterministic()->GetMinimized();
+	const auto table = dfa->Compile();
+	const RequiredInputs required(table, GetAccepting(*dfa, table));
+
+	std::vector<std::string> classBytes(dfa->GetInputs().size());
+	const auto& byteClasses = dfa->GetByteClasses();
+	for (size_t byte = 0; byte < byteClasses.size(); ++byte)
+	{
+		if (byteClasses[byte] != Machine::NO_ID)
+		{
+			classBytes[byteClasses[byte]] += static_cast<char>(byte);
+		}
+	}
+
+	// Every run of one byte classes in the required inputs is required too, the longest is kept.
+	std::string run;
+	for (const auto input : required.GetLiteral())
+	{
+		if (classBytes[input].size() != 1)
+		{
+			run.clear();
+			continue;
+		}
+		run += classBytes[input];
+		if (run.size() > matcher.literal.size())
+		{
+			matcher.literal = run;
+		}
+	}
+	for (const auto input : required.GetFirstInputs())
+	{
+		for (const auto byte : classBytes[input])
+		{
+			matcher.firstBytes += byte;
+			matcher.isFirstByte[static_cast<unsigned char>(byte)] = 1;
+		}
+	}
+
+	// Lines are scanned one by one, so what the prefilter looks for must not span lines.
+	if (!matcher.literal.empty() && matcher.literal.find('\n') == std::string::npos)
+	{
+		matcher.prefilter = Prefilter::LITERAL;
+	}
+	else if (!matcher.firstBytes.empty() && matcher.firstBytes.size() <= MAX_FIRST_BYTES && !matcher.isFirstByte['\n'])
+	{
+		matcher.prefilter = Prefilter::FIRST_BYTES;
+	}
+}
+
+// Builds the minimal DFA of "anything, then any of the expressions" and widens its columns to bytes.
+ByteMatcher CompileMatcher(std::vector<std::string> patterns)
+{
+	for (auto& pattern : patterns)
+	{
+		pattern = EscapeSpaces(pattern);
+	}
+
+	ByteMatcher matcher;
+	MooreMachine nfa;
+	if (patterns.size() == 1)
+	{
+		matcher.counting = nfa.FromRegularWithCounters(patterns.front());
+		if (matcher.counting)
+		{
+			return matcher;
+		}
+	}
+	else
+	{
+		nfa.FromRegular(patterns, MooreMachine::RegularConstruction::GLUSHKOV);
+	}
+	AddPrefilter(nfa, matcher);
+
+	// The start state of the Glushkov construction has no incoming edges, so looping it on every
+	// input lets a match begin anywhere in the line.
+	const auto start = nfa.GetInitialState();
+	const auto inputs = nfa.GetInputs();
+	for (const auto& input : inputs)
+	{
+		nfa.AddTransition(start, input, start);
+	}
+	nfa.AddTransition(start, OTHER_INPUT, start);
+
+	const auto dfa = nfa.GetDeterministic()->GetMinimized();
+	const auto table = dfa->Compile();
+	const auto& byteClasses = dfa->GetByteClasses();
+
+	std::array<TransitionTable::Id, 256> byteInputs{};
+	byteInputs.fill(dfa->GetInputId(OTHER_INPUT));
+	for (size_t byte = 0; byte < byteClasses.size(); ++byte)
+	{
+		if (byteClasses[byte] != Machine::NO_ID)
+		{
+			byteInputs[byte] = byteClasses[byte];
+		}
+	}
+
+	matcher.initialState = table.GetInitialState();
+	matcher.next.resize(table.GetStateCount() * byteInputs.size());
+	matcher.accepting = GetAccepting(*dfa, table);
+	for (TransitionTable::Id state = 0; state < table.GetStateCount(); ++state)
+	{
+		for (size_t byte = 0; byte < byteInputs.size(); ++byte)
+		{
+			// Every DFA state holds the looping start state, so no transition is missing.
+			matcher.next[state * byteInputs.size() + byte] = table.GetNextState(state, byteInputs[byte]);
+		}
+	}
+	return matcher;
+}
+
+// Position of the next literal or first byte, or the end of the text.
+size_t FindCandidate(const ByteMatcher& matcher, const std::string_view text, size_t position)
+{
+	if (matcher.prefilter == Prefilter::LITERAL)
+	{
+		const auto hit = text.find(matcher.literal, position);
+		return hit == std::string_view::npos ? text.size() : hit;
+	}
+	while (position < text.size() && !matcher.isFirstByte[static_cast<unsigned char>(text[position])])
+	{
+		++position;
+	}
+	return position;
+}
+
+// Whether the line holds a match. The line is mapped to input classes in one pass and run in one call.
+bool IsCountingMatch(CountingAutomaton& automaton, const std::string_view line, std::vector<CountingAutomaton::Id>& inputs)
+{
+	automaton.Reset(true);
+	if (automaton.IsAccepting())
+	{
+		return true;
+	}
+	const auto& byteClasses = automaton.GetByteClasses();
+	inputs.resize(line.size());
+	for (size_t i = 0; i < line.size(); ++i)
+	{
+		inputs[i] = byteClasses[static_cast<unsigned char>(line[i])];
+	}
+	return automaton.RunUntilAccepting(inputs) != CountingAutomaton::NOT_ACCEPTED;
+}
+
+void ScanCountingLines(const ByteMatcher& matcher, const Options& options, const std::string& prefix, const std::string_view text, Job& job)
+{
+	// A copy of the counting automaton, so that jobs can share the matcher.
+	auto automaton = *matcher.counting;
+	std::vector<CountingAutomaton::Id> inputs;
+	for (auto position = job.begin; position < job.end;)
+	{
+		const auto newLine = text.substr(0, job.end).find('\n', position);
+		const auto lineEnd = newLine == std::string_view::npos ? job.end : newLine;
+		const auto line = text.substr(position, lineEnd - position);
+		++job.candidates;
+		job.scannedBytes += line.size();
+		const auto lineStart = position;
+		position = lineEnd + 1;
+		if (!IsCountingMatch(automaton, line, inputs))
+		{
+			continue;
+		}
+
+		++job.count;
+		if (!options.count)
+		{
+			job.text += prefix;
+			if (options.byteOffset)
+			{
+				job.text += std::to_string(lineStart) + ":";
+			}
+			job.text += line;
+			job.text += '\n';
+		}
+	}
+}
+
+void ScanLines(const ByteMatcher& matcher, const Options& options, const std::string& prefix, std::string_view text, Job& job)
+{
+	if (matcher.counting)
+	{
+		ScanCountingLines(matcher, options, prefix, text, job);
+		return;
+	}
+	const auto* next = matcher.next.data();
+	const auto* accepting = matcher.accepting.data();
+	const auto* data = text.data();
+	text = text.substr(0, job.end);
+	for (auto position = job.begin; position < job.end;)
+	{
+		if (matcher.prefilter != Prefilter::NONE)
+		{
+			const auto hit = FindCandidate(matcher, text, position);
+			if (hit == job.end)
+			{
+				break;
+			}
+			const auto lineBreak = text.substr(position, hit - position).rfind('\n');
+			position = lineBreak == std::string_view::npos ? position : position + lineBreak + 1;
+		}
+
+		++job.candidates;
+		const auto lineStart = position;
+		auto state = matcher.initialState;
+		bool isMatch = accepting[state];
+		for (; !isMatch && position < job.end && data[position] != '\n'; ++position)
+		{
+			state = next[state * 256 + static_cast<unsigned char>(data[position])];
+			isMatch = accepting[state];
+		}
+		job.scannedBytes += position - lineStart;
+
+		const auto* newLine = static_cast<const char*>(std::memchr(data + position, '\n', job.end - position));
+		const auto lineEnd = newLine ? static_cast<size_t>(newLine - data) : job.end;
+		position = lineEnd + 1;
+		if (!isMatch)
+		{
+			continue;
+		}
+
+		++job.count;
+		if (!options.count)
+		{
+			job.text += prefix;
+			if (options.byteOffset)
+			{
+				job.text += std::to_string(lineStart) + ":";
+			}
+			job.text.append(data + lineStart, lineEnd - lineStart);
+			job.text += '\n';
+		}
+	}
+}
+
+// Splits the text at line ends into pieces of about CHUNK_SIZE bytes.
+void AddJobs(const size_t file, const std::string_view text, std::vector<Job>& jobs)
+{
+	size_t begin = 0;
+	do
+	{
+		auto end = std::min(text.size(), begin + CHUNK_SIZE);
+		if (end < text.size())
+		{
+			const auto newLine = text.find('\n', end);
+			end = newLine == std::string_view::npos ? text.size() : newLine + 1;
+		}
+		jobs.push_back({ file, begin, end, 0, 0, 0, {} });
+		begin = end;
+	} while (begin < text.size());
+}
+} // namespace
+
+// Prints the lines of the files that contain a match of the expression, like grep. The
+// expression goes through FromRegular, GetDeterministic and GetMinimized, so the syntax is the
+// one of FromRegular except that spaces are characters, and a backslash escapes metacharacters.
+// Expressions that unroll too far are matched by a CountingAutomaton, and the expressions of a
+// -f file share one DFA built by the multi-pattern FromRegular. Exits with 0 when a line
+// matched, 1 when none did and 2 on errors.
+int main(int argc, char* argv[])
+{
+	try
+	{
+		const auto options = ParseOptions(argc, argv);
+		const auto matcher = CompileMatcher(options.patterns);
+		ThreadPool pool(options.threadCount);
+		const bool showFileNames = options.fileNames.size() > 1;
+		size_t totalCount = 0;
+		size_t totalCandidates = 0;
+		size_t totalScanned = 0;
+		size_t totalBytes = 0;
+
+		for (size_t batchBegin = 0; batchBegin < options.fileNames.size(); batchBegin += BATCH_FILES)
+		{
+			const auto batchEnd = std::min(options.fileNames.size(), batchBegin + BATCH_FILES);
+			std::vector<std::unique_ptr<MappedFile>> files;
+			std::vector<std::string> prefixes;
+			std::vector<Job> jobs;
+			for (auto file = batchBegin; file < batchEnd; ++file)
+			{
+				const auto& fileName = options.fileNames[file];
+				files.push_back(std::make_unique<MappedFile>(fileName));
+				totalBytes += files.back()->GetText().size();
+				prefixes.push_back(showFileNames ? (fileName == "-" ? "(standard input)" : fileName) + ":" : "");
+				AddJobs(files.size() - 1, files.back()->GetText(), jobs);
+			}
+
+			pool.Run(jobs.size(), [&](const size_t job) {
+				ScanLines(matcher, options, prefixes[jobs[job].file], files[jobs[job].file]->GetText(), jobs[job]);
+			});
+
+			std::vector<size_t> fileCounts(files.size(), 0);
+			for (const auto& job : jobs)
+			{
+				fileCounts[job.file] += job.count;
+				totalCandidates += job.candidates;
+				totalScanned += job.scannedBytes;
+				std::cout.write(job.text.data(), static_cast<std::streamsize>(job.text.size()));
+			}
+			for (size_t file = 0; file < files.size(); ++file)
+			{
+				if (options.count)
+				{
+					std::cout << prefixes[file] << fileCounts[file] << '\n';
+				}
+				totalCount += fileCounts[file];
+			}
+		}
+		std::cout.flush();
+
+		if (options.stats)
+		{
+			const auto percent = [](const size_t part, const size_t whole) {
+				return whole == 0 ? 0.0 : 100.0 * static_cast<double>(part) / static_cast<double>(whole);
+			};
+			std::cerr << std::fixed << std::setprecision(1);
+			if (matcher.counting)
+			{
+				std::cerr << "engine: counting automaton with " << matcher.counting->GetCounterCount() << " counters"
+						  << std::endl;
+			}
+			switch (matcher.prefilter)
+			{
+			case Prefilter::LITERAL:
+				std::cerr << "prefilter: literal \"" << matcher.literal << "\"" << std::endl;
+				break;
+			case Prefilter::FIRST_BYTES:
+				std::cerr << "prefilter: first bytes \"" << matcher.firstBytes << "\"" << std::endl;
+				break;
+			default:
+				std::cerr << "prefilter: none" << std::endl;
+				break;
+			}
+			std::cerr << "candidate lines: " << totalCandidates << ", matching: " << totalCount << ", hit rate: "
+					  << percent(totalCount, totalCandidates) << "%" << std::endl;
+			std::cerr << "bytes run through the automaton: " << totalScanned << " of " << totalBytes << " ("
+					  << percent(totalScanned, totalBytes) << "%)" << std::endl;
+		}
+		return totalCount > 0 ? 0 : 1;
+	}
+	catch (const std::invalid_argument& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		PrintUsage();
+		return 2;
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 2;
+	}
+}
@@ -0,0 +1,67 @@
+#include "BinaryFormat.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace
+{
+constexpr size_t WRITE_BUFFER_SIZE = 1 << 20;
+} // namespace
+
+namespace BinaryFormat
+{
+void Checksum::Update(const std::span<const std::byte> bytes)
+{
+	for (size_t offset = 0; offset + sizeof(std::uint64_t) <= bytes.size(); offset += sizeof(std::uint64_t))
+	{
+		std::uint64_t word;
+		std::memcpy(&word, bytes.data() + offset, sizeof(word));
+		m_value = std::rotl(m_value ^ word, 27) * 0x9E3779B97F4A7C15;
+	}
+}
+
+Writer::Writer(std::ostream& stream)
+	: m_stream(stream)
+{
+	m_buffer.reserve(WRITE_BUFFER_SIZE + ALIGNMENT);
+}
+
+void Writer::Write(const void* data, size_t size)
+{
+	const auto* bytes = static_cast<const std::byte*>(data);
+	m_sectionSize += size;
+	while (size > 0)
+	{
+		const auto count = std::min(size, WRITE_BUFFER_SIZE - m_buffer.size());
+		m_buffer.insert(m_buffer.end(), bytes, bytes + count);
+		bytes += count;
+		size -= count;
+		if (m_buffer.size() >= WRITE_BUFFER_SIZE)
+		{
+			Flush(m_buffer.size() / ALIGNMENT * ALIGNMENT);
+		}
+	}
+}
+
+void Writer::EndSection()
+{
+	m_buffer.resize(m_buffer.size() + Align(m_sectionSize) - m_sectionSize, std::byte{ 0 });
+	m_sectionSize = 0;
+}
+
+std::uint64_t Writer::Finish()
+{
+	EndSection();
+	Flush(m_buffer.size());
+	return m_checksum.GetValue();
+}
+
+void Writer::Flush(const size_t size)
+{
+	const std::span<const std::byte> bytes(m_buffer.data(), size);
+	m_checksum.Update(bytes);
+	m_stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	m_buffer.erase(m_buffer.begin(), m_buffer.begin() + static_cast<std::ptrdiff_t>(size));
+}
+} // namespace BinaryFormat
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <vector>
+
+// Layout of the binary machine files written by SaveToBinary. After the header
+// come, each padded to 8 bytes: name offsets (uint64, states then inputs then
+// outputs, one extra end offset), state outputs (uint32, Moore machines only),
+// the input class of every byte (uint32, 256 entries or none for machines
+// without byte classes), first edge of every state (uint64, one extra end
+// entry), the edges and the name bytes. All sections are in host byte order
+// and covered by the checksum.
+namespace BinaryFormat
+{
+constexpr std::uint32_t MAGIC = 0x4D544155; // "AUTM"
+constexpr std::uint32_t VERSION = 2;
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr size_t ALIGNMENT = 8;
+
+enum class MachineKind : std::uint32_t
+{
+	MOORE = 1,
+	MEALY = 2
+};
+
+struct Header
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint32_t byteOrderMark;
+	MachineKind kind;
+	std::uint32_t stateCount;
+	std::uint32_t inputCount;
+	std::uint32_t outputCount;
+	std::uint32_t stateOutputCount;
+	std::uint32_t initialState;
+	std::uint32_t byteClassCount;
+	std::uint64_t edgeCount;
+	std::uint64_t nameBytes;
+	std::uint64_t checksum;
+};
+
+static_assert(sizeof(Header) % ALIGNMENT == 0);
+
+constexpr size_t Align(const size_t size)
+{
+	return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+// Hashes the sections 8 bytes at a time, every chunk must be a multiple of ALIGNMENT long.
+class Checksum
+{
+public:
+	void Update(std::span<const std::byte> bytes);
+
+	std::uint64_t GetValue() const
+	{
+		return m_value;
+	}
+
+private:
+	std::uint64_t m_value = 0x6A09E667F3BCC908;
+};
+
+// Buffers sections on their way to the stream and checksums them.
+class Writer
+{
+public:
+	explicit Writer(std::ostream& stream);
+
+	void Write(const void* data, size_t size);
+
+	// Pads the current section with zeros up to ALIGNMENT.
+	void EndSection();
+
+	// Flushes the buffer and returns the checksum of everything written.
+	std::uint64_t Finish();
+
+private:
+	void Flush(size_t size);
+
+	std::ostream& m_stream;
+	std::vector<std::byte> m_buffer;
+	size_t m_sectionSize = 0;
+	Checksum m_checksum;
+};
+} // namespace BinaryFormat
@@ -0,0 +1,167 @@
+#include "BitParallelNfa.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+constexpr size_t BYTE_VALUES = 256;
+} // namespace
+
+BitParallelNfa::BitParallelNfa(
+	const std::span<const Id> positionInputs,
+	const std::span<const size_t> firstFollow,
+	const std::span<const Id> follows,
+	const std::span<const char> accepting,
+	const size_t inputCount,
+	const Id acceptOutput,
+	const Id rejectOutput)
+	: m_positionCount(positionInputs.size())
+	, m_wordCount(m_positionCount <= 64 ? 1 : m_positionCount <= 128 ? 2 : 4)
+	, m_inputCount(inputCount)
+	, m_acceptOutput(acceptOutput)
+	, m_rejectOutput(rejectOutput)
+{
+	if (m_positionCount == 0 || m_positionCount > MAX_POSITIONS)
+	{
+		throw std::runtime_error("Bit-parallel simulation supports 1 to " + std::to_string(MAX_POSITIONS)
+			+ " positions, got " + std::to_string(m_positionCount) + ".");
+	}
+
+	// Every byte of the words gets entries, so a step reads a fixed number of them.
+	const auto byteCount = m_wordCount * 8;
+	m_followTable.assign(byteCount * BYTE_VALUES * m_wordCount, 0);
+	m_inputMasks.assign(m_inputCount * m_wordCount, 0);
+	for (size_t position = 0; position < m_positionCount; ++position)
+	{
+		if (position > 0 && positionInputs[position] < m_inputCount)
+		{
+			m_inputMasks[positionInputs[position] * m_wordCount + position / 64] |= std::uint64_t{ 1 } << (position % 64);
+		}
+		if (accepting[position])
+		{
+			m_acceptMask[position / 64] |= std::uint64_t{ 1 } << (position % 64);
+		}
+	}
+
+	// Entry v of byte b is the entry of v without its lowest bit plus the follows of that bit.
+	for (size_t byte = 0; byte < byteCount; ++byte)
+	{
+		auto* entries = m_followTable.data() + byte * BYTE_VALUES * m_wordCount;
+		for (size_t value = 1; value < BYTE_VALUES; ++value)
+		{
+			const auto lowest = static_cast<size_t>(std::countr_zero(value));
+			const auto position = byte * 8 + lowest;
+			auto* entry = entries + value * m_wordCount;
+			const auto* rest = entries + (value & (value - 1)) * m_wordCount;
+			std::copy(rest, rest + m_wordCount, entry);
+			if (position >= m_positionCount)
+			{
+				continue;
+			}
+			for (auto follow = firstFollow[position]; follow < firstFollow[position + 1]; ++follow)
+			{
+				entry[follows[follow] / 64] |= std::uint64_t{ 1 } << (follows[follow] % 64);
+			}
+		}
+	}
+	Reset();
+}
+
+void BitParallelNfa::Reset()
+{
+	m_active = {};
+	m_active[0] = 1;
+}
+
+size_t BitParallelNfa::Run(const std::span<const Id> inputs, const std::span<Id> outputs)
+{
+	if (!outputs.empty() && outputs.size() < inputs.size())
+	{
+		throw std::runtime_error("The output buffer is shorter than the input.");
+	}
+	switch (m_wordCount)
+	{
+	case 1:
+		return RunWords<1>(inputs, outputs);
+	case 2:
+		return RunWords<2>(inputs, outputs);
+	default:
+		return RunWords<4>(inputs, outputs);
+	}
+}
+
+bool BitParallelNfa::IsAccepting() const
+{
+	for (size_t word = 0; word < m_wordCount; ++word)
+	{
+		if (m_active[word] & m_acceptMask[word])
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+template <size_t WORDS>
+size_t BitParallelNfa::RunWords(const std::span<const Id> inputs, const std::span<Id> outputs)
+{
+	const auto* followTable = m_followTable.data();
+	const auto* inputMasks = m_inputMasks.data();
+	std::array<std::uint64_t, WORDS> active;
+	std::array<std::uint64_t, WORDS> acceptMask;
+	std::copy_n(m_active.begin(), WORDS, active.begin());
+	std::copy_n(m_acceptMask.begin(), WORDS, acceptMask.begin());
+	const auto save = [&] {
+		std::copy(active.begin(), active.end(), m_active.begin());
+	};
+
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		const auto input = inputs[i];
+		if (input >= m_inputCount)
+		{
+			save();
+			return i;
+		}
+
+		// Bytes past the last position are zero and their zero entries add nothing.
+		std::array<std::uint64_t, WORDS> next{};
+		for (size_t word = 0; word < WORDS; ++word)
+		{
+			for (size_t shift = 0; shift < 64; shift += 8)
+			{
+				const auto byte = word * 8 + shift / 8;
+				const auto* entry = followTable + (byte * BYTE_VALUES + ((active[word] >> shift) & 0xFF)) * WORDS;
+				for (size_t target = 0; target < WORDS; ++target)
+				{
+					next[target] |= entry[target];
+				}
+			}
+		}
+
+		std::uint64_t any = 0;
+		std::uint64_t accepts = 0;
+		for (size_t word = 0; word < WORDS; ++word)
+		{
+			next[word] &= inputMasks[input * WORDS + word];
+			any |= next[word];
+			accepts |= next[word] & acceptMask[word];
+		}
+		if (any == 0)
+		{
+			save();
+			return i;
+		}
+
+		active = next;
+		if (!outputs.empty())
+		{
+			outputs[i] = accepts ? m_acceptOutput : m_rejectOutput;
+		}
+	}
+	save();
+	return NOT_REJECTED;
+}
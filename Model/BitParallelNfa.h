@@ -0,0 +1,68 @@
+#pragma once
+
+#include "SymbolTable.h"
+#include "TransitionTable.h"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Simulates an accepting NFA with its active states in up to four machine words.
+// The states are Glushkov positions: the start and every (input, target) pair of
+// a transition, so all ways into a position read the same input. A step is then
+// S' = Follow(S) & Mask[input], with Follow(S) put together from precomputed
+// unions for every byte of S. Nothing is determinized, memory stays at a few
+// kilobytes and every input costs the same.
+class BitParallelNfa
+{
+public:
+	using Id = SymbolTable::Id;
+
+	static constexpr size_t MAX_POSITIONS = 256;
+	static constexpr size_t NOT_REJECTED = TransitionTable::RunResult::NOT_REJECTED;
+
+	// Position 0 is the start. positionInputs[p] is the input read to enter position p, the
+	// positions that can follow p are follows[firstFollow[p] ... firstFollow[p + 1]).
+	BitParallelNfa(
+		std::span<const Id> positionInputs,
+		std::span<const size_t> firstFollow,
+		std::span<const Id> follows,
+		std::span<const char> accepting,
+		size_t inputCount,
+		Id acceptOutput,
+		Id rejectOutput);
+
+	// Returns to the start position.
+	void Reset();
+
+	// Feeds the inputs from the current positions, outputs[i] receives the accept or reject output
+	// after inputs[i] and may be empty. Returns the index of the first input that leaves no
+	// position active, the positions then stay as before it, or NOT_REJECTED.
+	size_t Run(std::span<const Id> inputs, std::span<Id> outputs);
+
+	bool IsAccepting() const;
+
+	size_t GetPositionCount() const
+	{
+		return m_positionCount;
+	}
+
+private:
+	using Mask = std::array<std::uint64_t, MAX_POSITIONS / 64>;
+
+	template <size_t WORDS>
+	size_t RunWords(std::span<const Id> inputs, std::span<Id> outputs);
+
+	size_t m_positionCount;
+	size_t m_wordCount;
+	size_t m_inputCount;
+	Id m_acceptOutput;
+	Id m_rejectOutput;
+	// Union of the follows of every byte value of every byte of the active mask, m_wordCount words each.
+	std::vector<std::uint64_t> m_followTable;
+	// Positions entered by each input, m_wordCount words each.
+	std::vector<std::uint64_t> m_inputMasks;
+	Mask m_acceptMask{};
+	Mask m_active{};
+};
@@ -0,0 +1,232 @@
+#include "CountingAutomaton.h"
+#include "RegularTree.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+constexpr auto NO_ID = SymbolTable::NO_ID;
+constexpr auto UNBOUNDED = RegularTree::UNBOUNDED;
+} // namespace
+
+CountingAutomaton::CountingAutomaton(std::vector<Id> byteClasses, std::vector<Position> positions)
+	: m_byteClasses(std::move(byteClasses))
+	, m_positions(std::move(positions))
+{
+	m_isNullable = m_positions.front().isLast;
+	Compile();
+	Reset();
+}
+
+void CountingAutomaton::Reset(const bool isSearching)
+{
+	for (const auto position : m_active)
+	{
+		m_isActive[position] = false;
+	}
+	for (auto& counter : m_counters)
+	{
+		counter.Clear();
+	}
+	m_active.clear();
+	m_isSearching = isSearching;
+	m_isActive[0] = true;
+	m_step = 0;
+}
+
+size_t CountingAutomaton::Run(const std::span<const Id> inputs, const std::span<char> accepting)
+{
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		if (!Step(inputs[i]))
+		{
+			return i;
+		}
+		if (!accepting.empty())
+		{
+			accepting[i] = IsAccepting();
+		}
+	}
+	return NOT_REJECTED;
+}
+
+size_t CountingAutomaton::RunUntilAccepting(const std::span<const Id> inputs)
+{
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		if (!Step(inputs[i]))
+		{
+			return NOT_ACCEPTED;
+		}
+		if (IsAccepting())
+		{
+			return i;
+		}
+	}
+	return NOT_ACCEPTED;
+}
+
+bool CountingAutomaton::IsAccepting() const
+{
+	if (m_isActive[0] && m_isNullable)
+	{
+		return true;
+	}
+	return std::ranges::any_of(m_active, [this](const Id position) {
+		return m_positions[position].isLast && CanExit(position);
+	});
+}
+
+size_t CountingAutomaton::GetCounterCount() const
+{
+	return m_counters.size();
+}
+
+bool CountingAutomaton::CanExit(const Id position) const
+{
+	const auto counter = m_counterIndex[position];
+	if (counter == NO_ID)
+	{
+		return m_isActive[position];
+	}
+	// The oldest value is the largest.
+	const auto& set = m_counters[counter];
+	return !set.IsEmpty() && m_step - set.starts[set.head] >= m_positions[position].min;
+}
+
+bool CountingAutomaton::Keeps(const Id position, const Id input) const
+{
+	// A counted position stays with its values plus one while it reads the input and the youngest value stays within max.
+	const auto counter = m_counterIndex[position];
+	return counter != NO_ID && input != NO_ID && m_reads[position * m_inputCount + input]
+		&& m_step + 1 - m_counters[counter].starts.back() <= m_positions[position].max;
+}
+
+bool CountingAutomaton::Step(const Id input)
+{
+	// Positions entered with this input, from every position that can be left now.
+	++m_mark;
+	m_entered.clear();
+	const auto enter = [this, input](const Id from) {
+		for (auto i = m_firstFollow[from]; i < m_firstFollow[from + 1]; ++i)
+		{
+			const auto to = m_follows[i];
+			if (m_reads[to * m_inputCount + input] && m_marks[to] != m_mark)
+			{
+				m_marks[to] = m_mark;
+				m_entered.push_back(to);
+			}
+		}
+	};
+	if (input != NO_ID)
+	{
+		if (m_isActive[0])
+		{
+			enter(0);
+		}
+		for (const auto position : m_active)
+		{
+			if (CanExit(position))
+			{
+				enter(position);
+			}
+		}
+	}
+
+	m_next = m_entered;
+	for (const auto position : m_active)
+	{
+		if (m_marks[position] != m_mark && Keeps(position, input))
+		{
+			m_next.push_back(position);
+		}
+	}
+	if (m_next.empty() && !m_isSearching)
+	{
+		return false;
+	}
+
+	for (const auto position : m_active)
+	{
+		m_isActive[position] = false;
+		const auto counter = m_counterIndex[position];
+		if (counter == NO_ID)
+		{
+			continue;
+		}
+		auto& set = m_counters[counter];
+		if (!Keeps(position, input))
+		{
+			set.Clear();
+			continue;
+		}
+		while (m_step + 1 - set.starts[set.head] > m_positions[position].max)
+		{
+			set.head++;
+		}
+		if (set.head * 2 > set.starts.size())
+		{
+			set.starts.erase(set.starts.begin(), set.starts.begin() + static_cast<std::ptrdiff_t>(set.head));
+			set.head = 0;
+		}
+	}
+	for (const auto position : m_entered)
+	{
+		const auto counter = m_counterIndex[position];
+		// Without a maximum the oldest value covers every younger one.
+		if (counter != NO_ID && (m_counters[counter].IsEmpty() || m_positions[position].max != UNBOUNDED))
+		{
+			m_counters[counter].starts.push_back(m_step);
+		}
+	}
+	for (const auto position : m_next)
+	{
+		m_isActive[position] = true;
+	}
+	m_isActive[0] = m_isSearching;
+	std::swap(m_active, m_next);
+	m_step++;
+	return true;
+}
+
+void CountingAutomaton::Compile()
+{
+	m_inputCount = 1;
+	for (const auto byteClass : m_byteClasses)
+	{
+		if (byteClass != NO_ID)
+		{
+			m_inputCount = std::max<size_t>(m_inputCount, byteClass + 1);
+		}
+	}
+
+	const auto positionCount = m_positions.size();
+	m_reads.assign(positionCount * m_inputCount, 0);
+	m_firstFollow = { 0 };
+	m_counterIndex.assign(positionCount, NO_ID);
+	for (size_t position = 0; position < positionCount; ++position)
+	{
+		auto& info = m_positions[position];
+		for (const auto input : info.inputs)
+		{
+			m_reads[position * m_inputCount + input] = 1;
+		}
+
+		std::ranges::sort(info.follows);
+		info.follows.erase(std::unique(info.follows.begin(), info.follows.end()), info.follows.end());
+		m_follows.insert(m_follows.end(), info.follows.begin(), info.follows.end());
+		m_firstFollow.push_back(m_follows.size());
+
+		if (info.min != 1 || info.max != 1)
+		{
+			m_counterIndex[position] = static_cast<Id>(m_counters.size());
+			m_counters.emplace_back();
+		}
+		info.inputs = {};
+		info.follows = {};
+	}
+
+	m_isActive.assign(positionCount, 0);
+	m_marks.assign(positionCount, 0);
+}
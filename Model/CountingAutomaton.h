@@ -0,0 +1,119 @@
+#pragma once
+
+#include "SymbolTable.h"
+#include "TransitionTable.h"
+
+#include <span>
+#include <vector>
+
+// Matches regular expressions whose bounded repetitions would unroll into huge
+// automata. It runs on the Glushkov positions MooreMachine::FromRegularWithCounters
+// builds, where a repetition of one character or class, such as "[ab]{1000}" or
+// "(a|b){2,500}", stays a single position with a counter. Such a position holds
+// the set of counter values it has been reached with, kept as the steps they
+// started at: one step adds one to all of them for free, and dropping the values
+// past the maximum compares the oldest only.
+class CountingAutomaton
+{
+public:
+	using Id = SymbolTable::Id;
+
+	static constexpr size_t NOT_REJECTED = TransitionTable::RunResult::NOT_REJECTED;
+	static constexpr size_t NOT_ACCEPTED = NOT_REJECTED;
+	static constexpr size_t DEFAULT_UNROLL_LIMIT = 1 << 12;
+	static constexpr size_t MAX_POSITIONS = 1 << 20;
+
+	struct Position
+	{
+		// Inputs that enter the position and the positions that may come next.
+		std::vector<Id> inputs;
+		std::vector<Id> follows;
+		// Counter bounds, both 1 for positions without a counter. max may be RegularTree::UNBOUNDED.
+		size_t min = 1;
+		size_t max = 1;
+		// Whether a match may end at the position, for the start whether the empty input matches.
+		bool isLast = false;
+	};
+
+	// Takes the input class of every byte and the positions, position 0 is the start.
+	CountingAutomaton(std::vector<Id> byteClasses, std::vector<Position> positions);
+
+	// Returns to the start. A searching automaton keeps its start active, so matches may begin after any input.
+	void Reset(bool isSearching = false);
+
+	// Feeds the inputs, which are the byte classes of GetByteClasses() or NO_ID for other bytes.
+	// accepting[i] receives whether the automaton accepts after inputs[i] and may be empty.
+	// Returns the index of the first input that leaves no position active, the positions then
+	// stay as before it, or NOT_REJECTED.
+	size_t Run(std::span<const Id> inputs, std::span<char> accepting);
+
+	// Feeds the inputs like Run until the automaton accepts and returns the index of the input it
+	// accepts after, or NOT_ACCEPTED when it never does or no position stays active first.
+	size_t RunUntilAccepting(std::span<const Id> inputs);
+
+	bool IsAccepting() const;
+
+	// Input class of every byte, NO_ID for bytes the expression never reads.
+	const std::vector<Id>& GetByteClasses() const
+	{
+		return m_byteClasses;
+	}
+
+	// Positions including the start.
+	size_t GetPositionCount() const
+	{
+		return m_positions.size();
+	}
+
+	size_t GetCounterCount() const;
+
+private:
+	// Counter values of one position as the steps they started at, oldest first.
+	struct CountingSet
+	{
+		std::vector<size_t> starts;
+		size_t head = 0;
+
+		bool IsEmpty() const
+		{
+			return head == starts.size();
+		}
+
+		void Clear()
+		{
+			starts.clear();
+			head = 0;
+		}
+	};
+
+	bool CanExit(Id position) const;
+
+	// Returns false without changing anything when no position would stay active.
+	bool Step(Id input);
+
+	bool Keeps(Id position, Id input) const;
+
+	void Compile();
+
+	std::vector<Id> m_byteClasses;
+	size_t m_inputCount = 0;
+	// Inputs and follows are moved into m_reads and m_follows once compiled.
+	std::vector<Position> m_positions;
+	// Whether a position reads an input, and the follows of p as m_follows[m_firstFollow[p] ... m_firstFollow[p + 1]).
+	std::vector<char> m_reads;
+	std::vector<size_t> m_firstFollow;
+	std::vector<Id> m_follows;
+	bool m_isNullable = false;
+
+	// Simulation: the active positions, a flag for plain ones and a counting set for counted ones.
+	std::vector<Id> m_active;
+	std::vector<char> m_isActive;
+	std::vector<Id> m_counterIndex;
+	std::vector<CountingSet> m_counters;
+	bool m_isSearching = false;
+	size_t m_step = 0;
+	std::vector<Id> m_entered;
+	std::vector<Id> m_next;
+	std::vector<size_t> m_marks;
+	size_t m_mark = 0;
+};
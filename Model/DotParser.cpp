@@ -0,0 +1,368 @@
+#include "DotParser.h"
+
+namespace
+{
+bool IsIdCharacter(const char character)
+{
+	const auto byte = static_cast<unsigned char>(character);
+	return (byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') || (byte >= '0' && byte <= '9')
+		|| byte == '_' || byte == '.' || byte >= 0x80;
+}
+
+bool IsDigit(const char character)
+{
+	return character >= '0' && character <= '9';
+}
+
+bool IsEscaped(const char character)
+{
+	return character == '\\' || character == '"' || character == ',';
+}
+} // namespace
+
+std::optional<std::string_view> DotStatement::GetAttribute(const std::string_view name) const
+{
+	for (const auto& attribute : attributes)
+	{
+		if (attribute.name == name)
+		{
+			return attribute.value;
+		}
+	}
+	return std::nullopt;
+}
+
+DotParser::DotParser(const std::string_view text, const std::string_view sourceName)
+	: m_text(text)
+	, m_sourceName(sourceName)
+{
+}
+
+void DotParser::Parse(const StatementHandler& onStatement)
+{
+	auto token = Next();
+	if (token.type == TokenType::ID && token.text == "strict")
+	{
+		token = Next();
+	}
+	if (token.type != TokenType::ID || (token.text != "digraph" && token.text != "graph"))
+	{
+		Fail(token, "expected 'digraph'");
+	}
+	if (Peek().type == TokenType::ID)
+	{
+		Next();
+	}
+	Expect(TokenType::OPEN_BRACE, "'{'");
+
+	while (true)
+	{
+		token = Next();
+		if (token.type == TokenType::CLOSE_BRACE)
+		{
+			break;
+		}
+		if (token.type == TokenType::SEPARATOR)
+		{
+			continue;
+		}
+		if (token.type != TokenType::ID)
+		{
+			Fail(token, token.type == TokenType::END ? "expected '}'" : "expected a statement");
+		}
+
+		if (token.text == "node" || token.text == "edge" || token.text == "graph")
+		{
+			if (Peek().type == TokenType::OPEN_BRACKET)
+			{
+				ParseAttributes();
+				continue;
+			}
+		}
+		if (Peek().type == TokenType::EQUALS)
+		{
+			Next();
+			Expect(TokenType::ID, "a value");
+			continue;
+		}
+
+		m_nodes.clear();
+		m_nodes.push_back(token);
+		while (Peek().type == TokenType::ARROW)
+		{
+			Next();
+			m_nodes.push_back(Expect(TokenType::ID, "a node name"));
+		}
+
+		m_attributes.clear();
+		if (Peek().type == TokenType::OPEN_BRACKET)
+		{
+			ParseAttributes();
+		}
+
+		DotStatement statement{ token.text, {}, m_attributes, token.line, token.column };
+		if (m_nodes.size() == 1)
+		{
+			onStatement(statement);
+			continue;
+		}
+		for (size_t i = 1; i < m_nodes.size(); ++i)
+		{
+			statement.from = m_nodes[i - 1].text;
+			statement.to = m_nodes[i].text;
+			onStatement(statement);
+		}
+	}
+
+	token = Next();
+	if (token.type != TokenType::END)
+	{
+		Fail(token, "unexpected text after the graph");
+	}
+}
+
+std::runtime_error DotParser::MakeError(
+	const std::string_view sourceName,
+	const size_t line,
+	const size_t column,
+	const std::string_view message)
+{
+	return std::runtime_error(std::string(sourceName) + ":" + std::to_string(line) + ":" + std::to_string(column)
+		+ ": " + std::string(message));
+}
+
+std::string_view DotParser::Trim(std::string_view text)
+{
+	const auto first = text.find_first_not_of(" \t");
+	if (first == std::string_view::npos)
+	{
+		return {};
+	}
+	text.remove_prefix(first);
+	text.remove_suffix(text.size() - text.find_last_not_of(" \t") - 1);
+	return text;
+}
+
+void DotParser::SplitList(const std::string_view list, const std::function<void(std::string_view item)>& onItem)
+{
+	size_t itemStart = 0;
+	for (size_t position = 0; position < list.size(); ++position)
+	{
+		if (list[position] == '\\')
+		{
+			++position;
+		}
+		else if (list[position] == ',')
+		{
+			onItem(list.substr(itemStart, position - itemStart));
+			itemStart = position + 1;
+		}
+	}
+	onItem(list.substr(itemStart));
+}
+
+std::string DotParser::Unescape(const std::string_view text)
+{
+	std::string result;
+	result.reserve(text.size());
+	for (size_t position = 0; position < text.size(); ++position)
+	{
+		if (text[position] == '\\' && position + 1 < text.size() && IsEscaped(text[position + 1]))
+		{
+			++position;
+		}
+		result += text[position];
+	}
+	return result;
+}
+
+DotParser::Token DotParser::Next()
+{
+	if (m_peeked)
+	{
+		const auto token = *m_peeked;
+		m_peeked.reset();
+		return token;
+	}
+	return ReadToken();
+}
+
+const DotParser::Token& DotParser::Peek()
+{
+	if (!m_peeked)
+	{
+		m_peeked = ReadToken();
+	}
+	return *m_peeked;
+}
+
+DotParser::Token DotParser::Expect(const TokenType type, const std::string_view what)
+{
+	const auto token = Next();
+	if (token.type != type)
+	{
+		Fail(token, "expected " + std::string(what));
+	}
+	return token;
+}
+
+void DotParser::ParseAttributes()
+{
+	Expect(TokenType::OPEN_BRACKET, "'['");
+	while (true)
+	{
+		const auto token = Next();
+		if (token.type == TokenType::CLOSE_BRACKET)
+		{
+			return;
+		}
+		if (token.type == TokenType::SEPARATOR)
+		{
+			continue;
+		}
+		if (token.type != TokenType::ID)
+		{
+			Fail(token, "expected an attribute or ']'");
+		}
+
+		std::string_view value = "true";
+		if (Peek().type == TokenType::EQUALS)
+		{
+			Next();
+			value = Expect(TokenType::ID, "an attribute value").text;
+		}
+		m_attributes.push_back({ token.text, value });
+	}
+}
+
+void DotParser::SkipSpaceAndComments()
+{
+	while (m_position < m_text.size())
+	{
+		const auto character = m_text[m_position];
+		if (character == '\n')
+		{
+			++m_position;
+			++m_line;
+			m_lineStart = m_position;
+		}
+		else if (character == ' ' || character == '\t' || character == '\r')
+		{
+			++m_position;
+		}
+		else if (character == '#' || m_text.substr(m_position, 2) == "//")
+		{
+			const auto end = m_text.find('\n', m_position);
+			m_position = end == std::string_view::npos ? m_text.size() : end;
+		}
+		else if (m_text.substr(m_position, 2) == "/*")
+		{
+			const auto end = m_text.find("*/", m_position + 2);
+			if (end == std::string_view::npos)
+			{
+				Fail({ TokenType::END, {}, m_line, m_position - m_lineStart + 1 }, "unterminated comment");
+			}
+			for (; m_position < end + 2; ++m_position)
+			{
+				if (m_text[m_position] == '\n')
+				{
+					++m_line;
+					m_lineStart = m_position + 1;
+				}
+			}
+		}
+		else
+		{
+			return;
+		}
+	}
+}
+
+DotParser::Token DotParser::ReadToken()
+{
+	SkipSpaceAndComments();
+
+	Token token{ TokenType::END, {}, m_line, m_position - m_lineStart + 1 };
+	if (m_position == m_text.size())
+	{
+		return token;
+	}
+
+	const auto start = m_position;
+	const auto character = m_text[m_position];
+	switch (character)
+	{
+	case '{':
+		token.type = TokenType::OPEN_BRACE;
+		break;
+	case '}':
+		token.type = TokenType::CLOSE_BRACE;
+		break;
+	case '[':
+		token.type = TokenType::OPEN_BRACKET;
+		break;
+	case ']':
+		token.type = TokenType::CLOSE_BRACKET;
+		break;
+	case '=':
+		token.type = TokenType::EQUALS;
+		break;
+	case ';':
+	case ',':
+		token.type = TokenType::SEPARATOR;
+		break;
+	case '"':
+		token.type = TokenType::ID;
+		for (++m_position; m_position < m_text.size() && m_text[m_position] != '"'; ++m_position)
+		{
+			if (m_text[m_position] == '\\' && m_position + 1 < m_text.size())
+			{
+				++m_position;
+			}
+			if (m_text[m_position] == '\n')
+			{
+				++m_line;
+				m_lineStart = m_position + 1;
+			}
+		}
+		if (m_position == m_text.size())
+		{
+			Fail(token, "unterminated string");
+		}
+		token.text = m_text.substr(start + 1, m_position - start - 1);
+		++m_position;
+		return token;
+	default:
+		if (m_text.substr(m_position, 2) == "->")
+		{
+			token.type = TokenType::ARROW;
+			m_position += 2;
+			token.text = m_text.substr(start, 2);
+			return token;
+		}
+		if (character == '-' && m_position + 1 < m_text.size() && IsDigit(m_text[m_position + 1]))
+		{
+			++m_position;
+		}
+		while (m_position < m_text.size() && IsIdCharacter(m_text[m_position]))
+		{
+			++m_position;
+		}
+		if (m_position == start)
+		{
+			Fail(token, "unexpected character '" + std::string(1, character) + "'");
+		}
+		token.type = TokenType::ID;
+		token.text = m_text.substr(start, m_position - start);
+		return token;
+	}
+
+	++m_position;
+	token.text = m_text.substr(start, 1);
+	return token;
+}
+
+void DotParser::Fail(const Token& token, const std::string_view message) const
+{
+	throw MakeError(m_sourceName, token.line, token.column, message);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct DotAttribute
+{
+	std::string_view name;
+	std::string_view value;
+};
+
+struct DotStatement
+{
+	std::string_view from;
+	// Empty for node statements.
+	std::string_view to;
+	std::span<const DotAttribute> attributes;
+	size_t line;
+	size_t column;
+
+	bool IsEdge() const
+	{
+		return !to.empty();
+	}
+
+	std::optional<std::string_view> GetAttribute(std::string_view name) const;
+};
+
+// Single pass reader for the DOT subset the machines read and write: one graph
+// with node statements, edge statements and attribute lists. Names and values
+// are views into the text, quoted strings are returned without the quotes and
+// with escapes left as written, Unescape resolves the ones DotWriter adds.
+// Graph, node and edge defaults are skipped.
+class DotParser
+{
+public:
+	using StatementHandler = std::function<void(const DotStatement&)>;
+
+	DotParser(std::string_view text, std::string_view sourceName);
+
+	// Calls the handler for every node statement and for every edge of an edge statement.
+	void Parse(const StatementHandler& onStatement);
+
+	static std::runtime_error MakeError(
+		std::string_view sourceName,
+		size_t line,
+		size_t column,
+		std::string_view message);
+
+	static std::string_view Trim(std::string_view text);
+
+	// Calls the handler for every item of "a,b\,c" split at the commas without a backslash, the items
+	// keep their escapes. An empty list has one empty item.
+	static void SplitList(std::string_view list, const std::function<void(std::string_view item)>& onItem);
+
+	// Replaces the escapes DotWriter::WriteEscaped writes by the escaped character, others such as
+	// "\n" stay as written.
+	static std::string Unescape(std::string_view text);
+
+private:
+	enum class TokenType
+	{
+		ID,
+		ARROW,
+		EQUALS,
+		OPEN_BRACE,
+		CLOSE_BRACE,
+		OPEN_BRACKET,
+		CLOSE_BRACKET,
+		SEPARATOR,
+		END
+	};
+
+	struct Token
+	{
+		TokenType type;
+		std::string_view text;
+		size_t line;
+		size_t column;
+	};
+
+	Token Next();
+	const Token& Peek();
+	Token Expect(TokenType type, std::string_view what);
+	Token ReadToken();
+	void SkipSpaceAndComments();
+	void ParseAttributes();
+
+	[[noreturn]] void Fail(const Token& token, std::string_view message) const;
+
+	std::string_view m_text;
+	std::string_view m_sourceName;
+	size_t m_position = 0;
+	size_t m_line = 1;
+	size_t m_lineStart = 0;
+	std::optional<Token> m_peeked;
+	std::vector<Token> m_nodes;
+	std::vector<DotAttribute> m_attributes;
+};
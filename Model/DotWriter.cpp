@@ -0,0 +1,52 @@
+#include "DotWriter.h"
+
+#include <stdexcept>
+
+DotWriter::DotWriter(const std::string& fileName)
+	: m_fileName(fileName)
+{
+	m_file.rdbuf()->pubsetbuf(nullptr, 0);
+	m_file.open(fileName, std::ios::binary);
+	if (!m_file.is_open())
+	{
+		throw std::runtime_error("Cannot open file: " + fileName);
+	}
+	m_buffer.reserve(BUFFER_SIZE);
+}
+
+DotWriter::~DotWriter()
+{
+	if (m_file.is_open())
+	{
+		Flush();
+	}
+}
+
+DotWriter& DotWriter::WriteEscaped(const std::string_view text)
+{
+	for (const auto character : text)
+	{
+		if (character == '\\' || character == '"' || character == ',')
+		{
+			*this << '\\';
+		}
+		*this << character;
+	}
+	return *this;
+}
+
+void DotWriter::Close()
+{
+	Flush();
+	m_file.close();
+	if (!m_file)
+	{
+		throw std::runtime_error("Cannot write file: " + m_fileName);
+	}
+}
+
+void DotWriter::Flush()
+{
+	m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+	m_buffer.clear();
+}
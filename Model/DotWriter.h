@@ -0,0 +1,54 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <string_view>
+
+// Collects DOT text in one large reusable buffer and hands it to the file in
+// few big writes instead of flushing after every line.
+class DotWriter
+{
+public:
+	explicit DotWriter(const std::string& fileName);
+
+	DotWriter(const DotWriter&) = delete;
+	DotWriter& operator=(const DotWriter&) = delete;
+
+	~DotWriter();
+
+	DotWriter& operator<<(std::string_view text)
+	{
+		if (m_buffer.size() + text.size() > BUFFER_SIZE)
+		{
+			Flush();
+		}
+		m_buffer.append(text);
+		return *this;
+	}
+
+	DotWriter& operator<<(const char character)
+	{
+		if (m_buffer.size() == BUFFER_SIZE)
+		{
+			Flush();
+		}
+		m_buffer.push_back(character);
+		return *this;
+	}
+
+	// Writes the text for a quoted string with '\\', '"' and ',' behind a backslash, so that it
+	// survives a DOT round trip and never reads as a list separator. See DotParser::Unescape.
+	DotWriter& WriteEscaped(std::string_view text);
+
+	// Writes what is left and reports write errors, the destructor only flushes quietly.
+	void Close();
+
+private:
+	static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+	void Flush();
+
+	std::string m_fileName;
+	std::ofstream m_file;
+	std::string m_buffer;
+};
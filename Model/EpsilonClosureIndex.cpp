@@ -0,0 +1,128 @@
+#include "EpsilonClosureIndex.h"
+
+#include <algorithm>
+
+EpsilonClosureIndex::EpsilonClosureIndex(const std::span<const size_t> firstSuccessor, const std::span<const Id> successors)
+{
+	constexpr Id NO_ID = SymbolTable::NO_ID;
+	const auto stateCount = firstSuccessor.size() - 1;
+
+	struct Frame
+	{
+		Id state;
+		size_t nextSuccessor;
+	};
+
+	std::vector<Id> order(stateCount, NO_ID);
+	std::vector<Id> lowLink(stateCount, NO_ID);
+	std::vector<bool> isOnStack(stateCount, false);
+	std::vector<Id> componentStack;
+	std::vector<Frame> callStack;
+	std::vector<Id> closure;
+	StateMarker marker(stateCount);
+	Id nextOrder = 0;
+
+	m_components.assign(stateCount, NO_ID);
+
+	const auto visit = [&](const Id state) {
+		order[state] = lowLink[state] = nextOrder++;
+		componentStack.push_back(state);
+		isOnStack[state] = true;
+		callStack.push_back({ state, firstSuccessor[state] });
+	};
+
+	for (Id root = 0; root < stateCount; ++root)
+	{
+		if (order[root] != NO_ID)
+		{
+			continue;
+		}
+		visit(root);
+
+		while (!callStack.empty())
+		{
+			auto& frame = callStack.back();
+			const auto state = frame.state;
+			if (frame.nextSuccessor < firstSuccessor[state + 1])
+			{
+				const auto successor = successors[frame.nextSuccessor++];
+				if (order[successor] == NO_ID)
+				{
+					visit(successor);
+				}
+				else if (isOnStack[successor])
+				{
+					lowLink[state] = std::min(lowLink[state], order[successor]);
+				}
+				continue;
+			}
+
+			callStack.pop_back();
+			if (!callStack.empty())
+			{
+				auto& parent = lowLink[callStack.back().state];
+				parent = std::min(parent, lowLink[state]);
+			}
+			if (lowLink[state] != order[state])
+			{
+				continue;
+			}
+
+			// Components are completed after every component they reach, so their closures are ready.
+			const auto component = static_cast<Id>(GetComponentCount());
+			closure.clear();
+			marker.Reset();
+			Id member;
+			do
+			{
+				member = componentStack.back();
+				componentStack.pop_back();
+				isOnStack[member] = false;
+				m_components[member] = component;
+				marker.Insert(member);
+				closure.push_back(member);
+			} while (member != state);
+
+			const auto memberCount = closure.size();
+			for (size_t i = 0; i < memberCount; ++i)
+			{
+				const auto from = closure[i];
+				for (auto j = firstSuccessor[from]; j < firstSuccessor[from + 1]; ++j)
+				{
+					if (m_components[successors[j]] == component)
+					{
+						continue;
+					}
+					for (const auto reached : GetClosure(successors[j]))
+					{
+						if (marker.Insert(reached))
+						{
+							closure.push_back(reached);
+						}
+					}
+				}
+			}
+			std::ranges::sort(closure);
+			m_closures.insert(m_closures.end(), closure.begin(), closure.end());
+			m_offsets.push_back(m_closures.size());
+		}
+	}
+}
+
+void EpsilonClosureIndex::Close(std::vector<Id>& states, StateMarker& marker) const
+{
+	marker.Reset();
+	const auto seedCount = states.size();
+	for (size_t i = 0; i < seedCount; ++i)
+	{
+		for (const auto state : GetClosure(states[i]))
+		{
+			if (marker.Insert(state))
+			{
+				states.push_back(state);
+			}
+		}
+	}
+	states.erase(states.begin(), states.begin() + static_cast<std::ptrdiff_t>(seedCount));
+	std::ranges::sort(states);
+}
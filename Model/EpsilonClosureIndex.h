@@ -0,0 +1,38 @@
+#pragma once
+
+#include "StateSetTable.h"
+#include "SymbolTable.h"
+
+#include <span>
+#include <vector>
+
+// Epsilon closures of all states computed once. Strongly connected components
+// of the epsilon graph are collapsed with Tarjan's algorithm, then every
+// component gets the sorted closure shared by all of its states.
+class EpsilonClosureIndex
+{
+public:
+	using Id = SymbolTable::Id;
+
+	// The epsilon graph in CSR form: successors of state s are successors[firstSuccessor[s]...firstSuccessor[s + 1]).
+	EpsilonClosureIndex(std::span<const size_t> firstSuccessor, std::span<const Id> successors);
+
+	std::span<const Id> GetClosure(const Id state) const
+	{
+		const auto component = m_components[state];
+		return { m_closures.data() + m_offsets[component], m_offsets[component + 1] - m_offsets[component] };
+	}
+
+	// Replaces the states with the union of their closures, sorted.
+	void Close(std::vector<Id>& states, StateMarker& marker) const;
+
+	size_t GetComponentCount() const
+	{
+		return m_offsets.size() - 1;
+	}
+
+private:
+	std::vector<Id> m_components;
+	std::vector<size_t> m_offsets = { 0 };
+	std::vector<Id> m_closures;
+};
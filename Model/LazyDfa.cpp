@@ -0,0 +1,144 @@
+#include "LazyDfa.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+LazyDfa::LazyDfa(
+	std::vector<size_t> firstTransition,
+	std::vector<Transition> transitions,
+	EpsilonClosureIndex closures,
+	const Id initialState,
+	const size_t inputCount,
+	SubsetOutput subsetOutput,
+	const size_t cacheSize)
+	: m_firstTransition(std::move(firstTransition))
+	, m_transitions(std::move(transitions))
+	, m_closures(std::move(closures))
+	, m_inputCount(inputCount)
+	, m_subsetOutput(std::move(subsetOutput))
+	, m_cacheSize(cacheSize)
+	, m_initialSet({ initialState })
+	, m_marker(m_firstTransition.size() - 1)
+{
+	m_closures.Close(m_initialSet, m_marker);
+	AddState(m_initialSet);
+}
+
+void LazyDfa::Reset()
+{
+	// The initial state is added first after every flush, so it always has id 0.
+	m_current = 0;
+}
+
+size_t LazyDfa::Run(const std::span<const Id> inputs, const std::span<Id> outputs)
+{
+	if (!outputs.empty() && outputs.size() < inputs.size())
+	{
+		throw std::runtime_error("The output buffer is shorter than the input.");
+	}
+
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		const auto input = inputs[i];
+		if (input >= m_inputCount)
+		{
+			return i;
+		}
+		auto next = m_next[m_current * m_inputCount + input];
+		if (next == UNKNOWN)
+		{
+			next = Step(input);
+		}
+		if (next == SymbolTable::NO_ID)
+		{
+			return i;
+		}
+		m_current = next;
+		if (!outputs.empty())
+		{
+			outputs[i] = m_outputs[next];
+		}
+	}
+	return NOT_REJECTED;
+}
+
+LazyDfa::Id LazyDfa::Step(const Id input)
+{
+	m_scratch.clear();
+	for (const auto state : m_sets.GetSet(m_current))
+	{
+		const auto begin = m_transitions.begin() + static_cast<std::ptrdiff_t>(m_firstTransition[state]);
+		const auto end = m_transitions.begin() + static_cast<std::ptrdiff_t>(m_firstTransition[state + 1]);
+		const auto first = std::lower_bound(begin, end, input, [](const Transition& transition, const Id value) {
+			return transition.input < value;
+		});
+		for (auto it = first; it != end && it->input == input; ++it)
+		{
+			m_scratch.push_back(it->to);
+		}
+	}
+	if (m_scratch.empty())
+	{
+		m_next[m_current * m_inputCount + input] = SymbolTable::NO_ID;
+		return SymbolTable::NO_ID;
+	}
+	m_closures.Close(m_scratch, m_marker);
+
+	const auto [next, isNew] = m_sets.Intern(m_scratch);
+	if (isNew)
+	{
+		m_statistics.builtStates++;
+		if (m_cacheBytes + GetStateBytes(m_scratch.size()) > m_cacheSize && m_sets.Size() > 2)
+		{
+			// The new set goes with the rest of the cache, then the current state and it come back.
+			const auto currentSet = m_sets.GetSet(m_current);
+			const std::vector<Id> current(currentSet.begin(), currentSet.end());
+			Flush();
+			m_current = AddState(current);
+			const auto rebuilt = AddState(m_scratch);
+			m_next[m_current * m_inputCount + input] = rebuilt;
+			return rebuilt;
+		}
+		AppendState(m_scratch);
+	}
+	m_next[m_current * m_inputCount + input] = next;
+	return next;
+}
+
+LazyDfa::Id LazyDfa::AddState(const std::vector<Id>& states)
+{
+	const auto [id, isNew] = m_sets.Intern(states);
+	if (isNew)
+	{
+		AppendState(states);
+	}
+	return id;
+}
+
+void LazyDfa::AppendState(const std::vector<Id>& states)
+{
+	const auto output = m_subsetOutput(states);
+	if (!output)
+	{
+		throw std::runtime_error("Non-determinizable: Output conflict in a subset built by the lazy DFA.");
+	}
+	m_next.resize(m_next.size() + m_inputCount, UNKNOWN);
+	m_outputs.push_back(*output);
+	m_cacheBytes += GetStateBytes(states.size());
+}
+
+size_t LazyDfa::GetStateBytes(const size_t setSize) const
+{
+	return (setSize + m_inputCount + 1) * sizeof(Id);
+}
+
+void LazyDfa::Flush()
+{
+	m_statistics.flushes++;
+	m_sets.Clear();
+	m_next.clear();
+	m_outputs.clear();
+	m_cacheBytes = 0;
+	AddState(m_initialSet);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "EpsilonClosureIndex.h"
+#include "StateSetTable.h"
+#include "TransitionTable.h"
+
+#include <functional>
+#include <optional>
+#include <span>
+#include <vector>
+
+// Runs a Moore NFA through DFA states that are built from its subsets only when
+// the input first reaches them. Built states and their transitions live in a
+// cache of bounded size; when it is full the cache is flushed, the current
+// state is rebuilt and the run continues. Inputs that stay on known states run
+// at table speed without determinizing the whole machine up front.
+class LazyDfa
+{
+public:
+	using Id = SymbolTable::Id;
+
+	static constexpr size_t NOT_REJECTED = TransitionTable::RunResult::NOT_REJECTED;
+
+	struct Transition
+	{
+		Id input;
+		Id to;
+	};
+
+	// The output of a subset of NFA states, nullopt when the states disagree.
+	using SubsetOutput = std::function<std::optional<Id>(const std::vector<Id>& states)>;
+
+	struct Statistics
+	{
+		size_t builtStates = 0;
+		size_t flushes = 0;
+	};
+
+	// transitions[firstTransition[s] ... firstTransition[s + 1]) are the non epsilon transitions
+	// of NFA state s, sorted by input. The cache size is a budget in bytes.
+	LazyDfa(
+		std::vector<size_t> firstTransition,
+		std::vector<Transition> transitions,
+		EpsilonClosureIndex closures,
+		Id initialState,
+		size_t inputCount,
+		SubsetOutput subsetOutput,
+		size_t cacheSize);
+
+	// Returns to the initial state.
+	void Reset();
+
+	// Feeds the inputs from the current state, outputs[i] receives the output of the state entered
+	// on inputs[i] and may be empty. Returns the index of the first input without a transition,
+	// the current state then stays before it, or NOT_REJECTED.
+	size_t Run(std::span<const Id> inputs, std::span<Id> outputs);
+
+	Id GetOutput() const
+	{
+		return m_outputs[m_current];
+	}
+
+	const Statistics& GetStatistics() const
+	{
+		return m_statistics;
+	}
+
+private:
+	// Next state not built yet, NO_ID marks a missing transition.
+	static constexpr Id UNKNOWN = SymbolTable::NO_ID - 1;
+
+	Id Step(Id input);
+
+	Id AddState(const std::vector<Id>& states);
+
+	// Adds the row and output of a set just interned.
+	void AppendState(const std::vector<Id>& states);
+
+	// Cache bytes a state with this many NFA states takes.
+	size_t GetStateBytes(size_t setSize) const;
+
+	void Flush();
+
+	std::vector<size_t> m_firstTransition;
+	std::vector<Transition> m_transitions;
+	EpsilonClosureIndex m_closures;
+	size_t m_inputCount;
+	SubsetOutput m_subsetOutput;
+	size_t m_cacheSize;
+
+	std::vector<Id> m_initialSet;
+	StateSetTable m_sets;
+	StateMarker m_marker;
+	// Row of next states per built state.
+	std::vector<Id> m_next;
+	std::vector<Id> m_outputs;
+	size_t m_cacheBytes = 0;
+	Id m_current = 0;
+	std::vector<Id> m_scratch;
+	Statistics m_statistics;
+};
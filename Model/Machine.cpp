@@ -1,24 +1,55 @@
 #include "Machine.h"
+#include "MappedFile.h"
+#include "RefinablePartition.h"
+#include "ThreadPool.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <map>
-#include <unordered_map>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
 
-std::vector<std::vector<Machine::State>> Machine::BreakForPartitions(
-	const std::vector<std::vector<State>>& initialPartitions
-) const
+Machine::Partitions Machine::RefinePartitions(
+	const TransitionTable& table,
+	const Partitions& initialPartitions,
+	const MinimizeOptions& options) const
 {
+	switch (options.algorithm)
+	{
+	case MinimizationAlgorithm::MOORE_REFINEMENT:
+		if (ThreadPool::ResolveThreadCount(options.threadCount) > 1)
+		{
+			return BreakForPartitionsParallel(table, initialPartitions, options.threadCount);
+		}
+		return BreakForPartitions(table, initialPartitions);
+
+	case MinimizationAlgorithm::HOPCROFT:
+		return BreakForPartitionsHopcroft(table, initialPartitions);
+	}
+	throw std::runtime_error("Unknown minimization algorithm.");
+}
+
+Machine::Partitions Machine::BreakForPartitions(
+	const TransitionTable& table,
+	const Partitions& initialPartitions) const
+{
+	const auto inputCount = table.GetInputCount();
 	auto partitions = initialPartitions;
+	std::vector<int> stateToGroupIndex(m_states.Size(), -1);
+
 	while (true)
 	{
-		std::unordered_map<State, int> stateToGroupIndex;
 		for (int i = 0; i < partitions.size(); ++i)
 		{
-			for (const auto& state : partitions[i])
+			for (const auto state : partitions[i])
 			{
 				stateToGroupIndex[state] = i;
 			}
 		}
-		std::vector<std::vector<State>> newPartitions;
+		Partitions newPartitions;
 
 		bool hasChanged = false;
 		for (const auto& group : partitions)
@@ -29,18 +60,17 @@ std::vector<std::vector<Machine::State>> Machine::BreakForPartitions(
 				continue;
 			}
 
-			std::map<std::vector<int>, std::vector<State>> subGroups;
-			for (const auto& state : group)
+			std::map<std::vector<int>, std::vector<StateId>> subGroups;
+			for (const auto state : group)
 			{
-				std::vector<int> destinationGroups;
-				for (const auto& input : m_inputs)
+				std::vector<int> destinationGroups(inputCount, -1);
+				const auto* row = table.GetRow(state);
+				for (InputId input = 0; input < inputCount; ++input)
 				{
-					if (!HasTransition(state, input))
+					if (row[input] != NO_ID)
 					{
-						continue;
+						destinationGroups[input] = stateToGroupIndex[row[input]];
 					}
-					State nextState = GetNextState(state, input);
-					destinationGroups.push_back(stateToGroupIndex.at(nextState));
 				}
 				subGroups[destinationGroups].push_back(state);
 			}
@@ -50,12 +80,12 @@ std::vector<std::vector<Machine::State>> Machine::BreakForPartitions(
 				hasChanged = true;
 			}
 
-			for (const auto& pair : subGroups)
+			for (auto& subGroup : subGroups)
 			{
-				newPartitions.push_back(pair.second);
+				newPartitions.push_back(std::move(subGroup.second));
 			}
 		}
-		partitions = newPartitions;
+		partitions = std::move(newPartitions);
 
 		if (!hasChanged)
 		{
@@ -63,4 +93,904 @@ std::vector<std::vector<Machine::State>> Machine::BreakForPartitions(
 		}
 	}
 	return partitions;
-}
\ No newline at end of file
+}
+
+Machine::Partitions Machine::BreakForPartitionsParallel(
+	const TransitionTable& table,
+	const Partitions& initialPartitions,
+	const size_t threadCount) const
+{
+	const auto inputCount = table.GetInputCount();
+	ThreadPool pool(threadCount);
+	auto partitions = initialPartitions;
+	std::vector<int> stateToGroupIndex(m_states.Size(), -1);
+	std::vector<int> signatures;
+
+	while (true)
+	{
+		// Each task owns a contiguous range of groups holding about the same number of states.
+		std::vector<size_t> groupOffsets(partitions.size() + 1, 0);
+		for (size_t i = 0; i < partitions.size(); ++i)
+		{
+			groupOffsets[i + 1] = groupOffsets[i] + partitions[i].size();
+		}
+		const auto stateCount = groupOffsets.back();
+		const auto taskCount = std::min(partitions.size(), pool.GetThreadCount() * 4);
+		std::vector<size_t> taskGroups(taskCount + 1, partitions.size());
+		taskGroups[0] = 0;
+		for (size_t task = 1, group = 0; task < taskCount; ++task)
+		{
+			while (group < partitions.size() && groupOffsets[group] * taskCount < stateCount * task)
+			{
+				++group;
+			}
+			taskGroups[task] = group;
+		}
+
+		pool.Run(taskCount, [&](const size_t task) {
+			for (auto group = taskGroups[task]; group < taskGroups[task + 1]; ++group)
+			{
+				for (const auto state : partitions[group])
+				{
+					stateToGroupIndex[state] = static_cast<int>(group);
+				}
+			}
+		});
+
+		signatures.assign(stateCount * inputCount, -1);
+		pool.Run(taskCount, [&](const size_t task) {
+			for (auto group = taskGroups[task]; group < taskGroups[task + 1]; ++group)
+			{
+				if (partitions[group].size() <= 1)
+				{
+					continue;
+				}
+				auto* signature = signatures.data() + groupOffsets[group] * inputCount;
+				for (const auto state : partitions[group])
+				{
+					const auto* row = table.GetRow(state);
+					for (InputId input = 0; input < inputCount; ++input)
+					{
+						if (row[input] != NO_ID)
+						{
+							signature[input] = stateToGroupIndex[row[input]];
+						}
+					}
+					signature += inputCount;
+				}
+			}
+		});
+
+		std::vector<Partitions> taskPartitions(taskCount);
+		std::vector<char> taskChanged(taskCount, 0);
+		pool.Run(taskCount, [&](const size_t task) {
+			std::vector<size_t> order;
+			for (auto group = taskGroups[task]; group < taskGroups[task + 1]; ++group)
+			{
+				const auto& states = partitions[group];
+				if (states.size() <= 1)
+				{
+					taskPartitions[task].push_back(states);
+					continue;
+				}
+
+				const auto* groupSignatures = signatures.data() + groupOffsets[group] * inputCount;
+				const auto signatureLess = [&](const size_t a, const size_t b) {
+					return std::lexicographical_compare(
+						groupSignatures + a * inputCount, groupSignatures + (a + 1) * inputCount,
+						groupSignatures + b * inputCount, groupSignatures + (b + 1) * inputCount);
+				};
+
+				// A stable sort by signature yields the subgroups in the order of the std::map used by the serial rounds.
+				order.resize(states.size());
+				std::iota(order.begin(), order.end(), 0);
+				std::ranges::stable_sort(order, signatureLess);
+
+				for (size_t i = 0; i < order.size(); ++i)
+				{
+					if (i == 0 || signatureLess(order[i - 1], order[i]))
+					{
+						taskPartitions[task].emplace_back();
+						taskChanged[task] |= i != 0;
+					}
+					taskPartitions[task].back().push_back(states[order[i]]);
+				}
+			}
+		});
+
+		Partitions newPartitions;
+		newPartitions.reserve(partitions.size());
+		for (auto& partsOfTask : taskPartitions)
+		{
+			std::ranges::move(partsOfTask, std::back_inserter(newPartitions));
+		}
+		partitions = std::move(newPartitions);
+
+		if (std::ranges::find(taskChanged, 1) == taskChanged.end())
+		{
+			break;
+		}
+	}
+	return partitions;
+}
+
+Machine::Partitions Machine::BreakForPartitionsHopcroft(
+	const TransitionTable& table,
+	const Partitions& initialPartitions) const
+{
+	const auto stateCount = table.GetStateCount();
+	const auto inputCount = table.GetInputCount();
+
+	// Transitions are numbered and grouped by input, these groups are the initial splitters.
+	std::vector<StateId> tails;
+	std::vector<StateId> heads;
+	std::vector<std::vector<StateId>> transitionsByInput(inputCount);
+	for (InputId input = 0; input < inputCount; ++input)
+	{
+		for (StateId state = 0; state < stateCount; ++state)
+		{
+			const auto nextState = table.GetNextState(state, input);
+			if (nextState == NO_ID)
+			{
+				continue;
+			}
+			transitionsByInput[input].push_back(static_cast<StateId>(tails.size()));
+			tails.push_back(state);
+			heads.push_back(nextState);
+		}
+	}
+
+	std::vector<size_t> firstIncoming(stateCount + 1, 0);
+	for (const auto head : heads)
+	{
+		++firstIncoming[head + 1];
+	}
+	for (size_t state = 0; state < stateCount; ++state)
+	{
+		firstIncoming[state + 1] += firstIncoming[state];
+	}
+	std::vector<StateId> incoming(heads.size());
+	auto fillPosition = firstIncoming;
+	for (StateId transition = 0; transition < heads.size(); ++transition)
+	{
+		incoming[fillPosition[heads[transition]]++] = transition;
+	}
+
+	RefinablePartition blocks(stateCount, initialPartitions);
+	RefinablePartition splitters(heads.size(), transitionsByInput);
+
+	// The first block is never used as a splitter: splitting by all transitions on an input
+	// and by those into the other blocks already separates the ones into it.
+	size_t block = 1;
+	size_t splitter = 0;
+	while (splitter < splitters.GetSetCount())
+	{
+		for (const auto transition : splitters.GetElements(splitter))
+		{
+			blocks.Mark(tails[transition]);
+		}
+		blocks.Split();
+		++splitter;
+
+		while (block < blocks.GetSetCount())
+		{
+			for (const auto state : blocks.GetElements(block))
+			{
+				for (auto i = firstIncoming[state]; i < firstIncoming[state + 1]; ++i)
+				{
+					splitters.Mark(incoming[i]);
+				}
+			}
+			splitters.Split();
+			++block;
+		}
+	}
+
+	Partitions partitions;
+	std::vector<size_t> blockToPartition(blocks.GetSetCount(), NO_ID);
+	for (StateId state = 0; state < stateCount; ++state)
+	{
+		auto& partition = blockToPartition[blocks.GetSetOf(state)];
+		if (partition == NO_ID)
+		{
+			partition = partitions.size();
+			partitions.emplace_back();
+		}
+		partitions[partition].push_back(state);
+	}
+	return partitions;
+}
+
+TransitionTable Machine::CompileTransitions() const
+{
+	TransitionTable table(m_states.Size(), m_inputs.Size());
+	for (StateId state = 0; state < m_edges.size(); ++state)
+	{
+		for (const auto& edge : m_edges[state])
+		{
+			if (edge.input == EPSILON_ID || table.GetNextState(state, edge.input) != NO_ID)
+			{
+				throw std::runtime_error("Cannot compile a non-deterministic machine. Call GetDeterministic() first.");
+			}
+			table.SetNextState(state, edge.input, edge.to);
+		}
+	}
+	table.SetInitialState(m_initialState);
+	return table;
+}
+
+Machine::StateId Machine::AddState(const std::string_view state)
+{
+	const auto id = m_states.Intern(state);
+	if (id >= m_edges.size())
+	{
+		m_edges.resize(id + 1);
+	}
+	return id;
+}
+
+Machine::InputId Machine::AddInput(const std::string_view input)
+{
+	if (input.empty())
+	{
+		return EPSILON_ID;
+	}
+	return m_inputs.Intern(input);
+}
+
+Machine::StateId Machine::FindState(const std::string_view state) const
+{
+	return m_states.Find(state);
+}
+
+Machine::InputId Machine::FindInput(const std::string_view input) const
+{
+	if (input.empty())
+	{
+		return EPSILON_ID;
+	}
+	const auto id = m_inputs.Find(input);
+	if (id == NO_ID && input.size() == 1 && !m_byteClasses.empty())
+	{
+		return m_byteClasses[static_cast<unsigned char>(input[0])];
+	}
+	return id;
+}
+
+std::string Machine::GetStateName(const StateId state) const
+{
+	if (state == NO_ID)
+	{
+		return {};
+	}
+	return m_states.GetName(state);
+}
+
+std::string Machine::GetInputName(const InputId input) const
+{
+	if (input == EPSILON_ID || input == NO_ID)
+	{
+		return {};
+	}
+	return m_inputs.GetName(input);
+}
+
+bool Machine::HasEdge(const StateId from, const InputId input) const
+{
+	return GetNextStateId(from, input) != NO_ID;
+}
+
+Machine::StateId Machine::GetNextStateId(const StateId from, const InputId input) const
+{
+	if (from == NO_ID || input == NO_ID)
+	{
+		return NO_ID;
+	}
+	for (const auto& edge : m_edges[from])
+	{
+		if (edge.input == input)
+		{
+			return edge.to;
+		}
+	}
+	return NO_ID;
+}
+
+std::vector<bool> Machine::GetReachableStates() const
+{
+	std::vector<bool> reachable(m_states.Size(), false);
+	if (m_initialState == NO_ID)
+	{
+		return reachable;
+	}
+
+	std::queue<StateId> queue;
+	queue.push(m_initialState);
+	reachable[m_initialState] = true;
+
+	while (!queue.empty())
+	{
+		const auto current = queue.front();
+		queue.pop();
+
+		for (const auto& edge : m_edges[current])
+		{
+			if (reachable[edge.to])
+			{
+				continue;
+			}
+			reachable[edge.to] = true;
+			queue.push(edge.to);
+		}
+	}
+	return reachable;
+}
+
+EpsilonClosureIndex Machine::BuildEpsilonClosureIndex() const
+{
+	std::vector<size_t> firstSuccessor(m_edges.size() + 1, 0);
+	std::vector<StateId> successors;
+	for (StateId state = 0; state < m_edges.size(); ++state)
+	{
+		for (const auto& edge : m_edges[state])
+		{
+			if (edge.input == EPSILON_ID)
+			{
+				successors.push_back(edge.to);
+			}
+		}
+		firstSuccessor[state + 1] = successors.size();
+	}
+	return { firstSuccessor, successors };
+}
+
+std::vector<Machine::StateId> Machine::CompactStates(const std::vector<bool>& keep)
+{
+	std::vector<StateId> oldToNew(m_states.Size(), NO_ID);
+	SymbolTable newStates;
+	std::vector<std::vector<Edge>> newEdges;
+
+	for (StateId state = 0; state < m_states.Size(); ++state)
+	{
+		if (!keep[state])
+		{
+			continue;
+		}
+		oldToNew[state] = newStates.Intern(m_states.GetName(state));
+	}
+
+	newEdges.resize(newStates.Size());
+	for (StateId state = 0; state < m_states.Size(); ++state)
+	{
+		if (oldToNew[state] == NO_ID)
+		{
+			continue;
+		}
+		auto& edges = newEdges[oldToNew[state]];
+		for (const auto& edge : m_edges[state])
+		{
+			if (oldToNew[edge.to] != NO_ID)
+			{
+				edges.push_back({ edge.input, oldToNew[edge.to], edge.output });
+			}
+		}
+	}
+
+	m_states = std::move(newStates);
+	m_edges = std::move(newEdges);
+	m_initialState = m_initialState == NO_ID ? NO_ID : oldToNew[m_initialState];
+	m_currentState = m_currentState == NO_ID ? NO_ID : oldToNew[m_currentState];
+	return oldToNew;
+}
+
+std::vector<Machine::OutputId> Machine::GetOutputRanks() const
+{
+	std::vector<OutputId> byName(m_outputs.Size());
+	std::iota(byName.begin(), byName.end(), 0);
+	std::ranges::sort(byName, [this](const OutputId a, const OutputId b) {
+		return m_outputs.GetName(a) < m_outputs.GetName(b);
+	});
+
+	std::vector<OutputId> ranks(m_outputs.Size());
+	for (OutputId rank = 0; rank < byName.size(); ++rank)
+	{
+		ranks[byName[rank]] = rank;
+	}
+	return ranks;
+}
+
+void Machine::ClearMachine()
+{
+	m_states.Clear();
+	m_inputs.Clear();
+	m_outputs.Clear();
+	m_edges.clear();
+	m_byteClasses.clear();
+}
+
+size_t Machine::CompressInputs()
+{
+	auto byteClasses = m_byteClasses;
+	if (byteClasses.empty())
+	{
+		byteClasses.assign(BYTE_COUNT, NO_ID);
+		for (InputId input = 0; input < m_inputs.Size(); ++input)
+		{
+			const auto& name = m_inputs.GetName(input);
+			if (name.size() == 1)
+			{
+				byteClasses[static_cast<unsigned char>(name[0])] = input;
+			}
+		}
+	}
+	std::vector<bool> isByteInput(m_inputs.Size(), false);
+	for (const auto input : byteClasses)
+	{
+		if (input != NO_ID)
+		{
+			isByteInput[input] = true;
+		}
+	}
+
+	// Two inputs behave the same when their (from, to, output) edges are the same.
+	using EdgeKey = std::array<SymbolTable::Id, 3>;
+	std::vector<std::vector<EdgeKey>> signatures(m_inputs.Size());
+	for (StateId from = 0; from < m_edges.size(); ++from)
+	{
+		for (const auto& edge : m_edges[from])
+		{
+			if (edge.input != EPSILON_ID)
+			{
+				signatures[edge.input].push_back({ from, edge.to, edge.output });
+			}
+		}
+	}
+
+	std::map<std::vector<EdgeKey>, InputId> classBySignature;
+	std::vector<InputId> classOfInput(m_inputs.Size());
+	std::vector<bool> isRepresentative(m_inputs.Size(), false);
+	std::vector<std::string> classNames;
+	std::vector<bool> isMerged;
+	for (InputId input = 0; input < m_inputs.Size(); ++input)
+	{
+		const auto& name = m_inputs.GetName(input);
+		auto inputClass = static_cast<InputId>(classNames.size());
+		if (isByteInput[input])
+		{
+			std::ranges::sort(signatures[input]);
+			inputClass = classBySignature.try_emplace(std::move(signatures[input]), inputClass).first->second;
+		}
+		classOfInput[input] = inputClass;
+		isRepresentative[input] = inputClass == classNames.size();
+		if (isRepresentative[input])
+		{
+			classNames.push_back(name);
+			isMerged.push_back(false);
+		}
+		else
+		{
+			isMerged[inputClass] = true;
+		}
+	}
+
+	// Members of a class have the same edges, so the edges of the first one stand for all.
+	for (auto& edges : m_edges)
+	{
+		std::erase_if(edges, [&](const Edge& edge) {
+			return edge.input != EPSILON_ID && !isRepresentative[edge.input];
+		});
+		for (auto& edge : edges)
+		{
+			if (edge.input != EPSILON_ID)
+			{
+				edge.input = classOfInput[edge.input];
+			}
+		}
+	}
+	std::vector<std::vector<unsigned char>> classBytes(classNames.size());
+	for (size_t byte = 0; byte < BYTE_COUNT; ++byte)
+	{
+		if (byteClasses[byte] != NO_ID)
+		{
+			byteClasses[byte] = classOfInput[byteClasses[byte]];
+			classBytes[byteClasses[byte]].push_back(static_cast<unsigned char>(byte));
+		}
+	}
+	m_inputs.Clear();
+	for (InputId inputClass = 0; inputClass < classNames.size(); ++inputClass)
+	{
+		m_inputs.Intern(isMerged[inputClass] ? GetBytesName(classBytes[inputClass]) : classNames[inputClass]);
+	}
+	m_byteClasses = std::move(byteClasses);
+	return m_inputs.Size();
+}
+
+Machine::Input Machine::GetBytesName(const std::vector<unsigned char>& bytes)
+{
+	Input name;
+	for (size_t begin = 0; begin < bytes.size();)
+	{
+		auto end = begin + 1;
+		while (end < bytes.size() && bytes[end] == bytes[end - 1] + 1)
+		{
+			end++;
+		}
+		name += begin > 0 ? "|" : "";
+		if (end - begin >= 3)
+		{
+			name += static_cast<char>(bytes[begin]);
+			name += '-';
+			name += static_cast<char>(bytes[end - 1]);
+		}
+		else
+		{
+			for (auto i = begin; i < end; ++i)
+			{
+				name += i > begin ? "|" : "";
+				name += static_cast<char>(bytes[i]);
+			}
+		}
+		begin = end;
+	}
+	return name;
+}
+
+void Machine::InheritByteClasses(const Machine& source)
+{
+	if (!source.m_byteClasses.empty())
+	{
+		m_byteClasses = source.m_byteClasses;
+		CompressInputs();
+	}
+}
+
+void Machine::LoadDot(const std::string& fileName, const DotNodeHandler& onNode, const DotEdgeHandler& onEdge)
+{
+	const MappedFile file(fileName);
+
+	std::vector<std::string_view> markers;
+	std::string_view initialState;
+	std::string_view markedState;
+
+	DotParser parser(file.GetText(), fileName);
+	parser.Parse([&](const DotStatement& statement) {
+		if (!statement.IsEdge())
+		{
+			const auto shape = statement.GetAttribute("shape");
+			if (shape == "point")
+			{
+				markers.push_back(statement.from);
+				return;
+			}
+			if (shape == "doublecircle")
+			{
+				initialState = statement.from;
+			}
+			onNode(AddState(statement.from), statement);
+			return;
+		}
+
+		if (std::ranges::find(markers, statement.from) != markers.end())
+		{
+			markedState = statement.to;
+			return;
+		}
+		const auto from = AddState(statement.from);
+		onEdge(from, AddState(statement.to), statement);
+	});
+
+	if (initialState.empty())
+	{
+		initialState = markedState;
+	}
+	if (!initialState.empty())
+	{
+		m_initialState = AddState(initialState);
+		m_currentState = m_initialState;
+	}
+	else if (!m_states.Empty())
+	{
+		m_initialState = 0;
+		m_currentState = 0;
+	}
+}
+
+void Machine::WriteDotEdges(DotWriter& writer, const DotOptions& options, const DotLabelWriter& writeLabel) const
+{
+	std::vector<uint32_t> groupOfTarget(m_states.Size(), NO_ID);
+	std::vector<StateId> targets;
+	std::vector<uint32_t> order;
+
+	for (StateId from = 0; from < m_edges.size(); ++from)
+	{
+		const auto& edges = m_edges[from];
+		if (!options.mergeParallelEdges)
+		{
+			for (const auto& edge : edges)
+			{
+				writer << "    " << m_states.GetName(from) << " -> " << m_states.GetName(edge.to) << " [label=\"";
+				writeLabel(writer, edge);
+				writer << "\"];\n";
+			}
+			continue;
+		}
+
+		targets.clear();
+		for (const auto& edge : edges)
+		{
+			if (groupOfTarget[edge.to] == NO_ID)
+			{
+				groupOfTarget[edge.to] = static_cast<uint32_t>(targets.size());
+				targets.push_back(edge.to);
+			}
+		}
+		order.resize(edges.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::ranges::stable_sort(order, {}, [&](const uint32_t edge) {
+			return groupOfTarget[edges[edge].to];
+		});
+
+		size_t groupStart = 0;
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			const auto& edge = edges[order[i]];
+			if (i == 0 || edges[order[i - 1]].to != edge.to)
+			{
+				writer << "    " << m_states.GetName(from) << " -> " << m_states.GetName(edge.to) << " [label=\"";
+				groupStart = i;
+			}
+			else
+			{
+				writer << ',';
+			}
+			writeLabel(writer, edge);
+			if (i + 1 == order.size() || edges[order[i + 1]].to != edge.to)
+			{
+				writer << (i > groupStart ? "\", merged=true];\n" : "\"];\n");
+			}
+		}
+
+		for (const auto target : targets)
+		{
+			groupOfTarget[target] = NO_ID;
+		}
+	}
+}
+
+void Machine::WriteBinary(
+	const std::string& fileName,
+	const BinaryFormat::MachineKind kind,
+	const std::span<const OutputId> stateOutputs)
+{
+	static_assert(std::is_trivially_copyable_v<Edge> && sizeof(Edge) == 3 * sizeof(SymbolTable::Id));
+
+	std::ofstream file(fileName, std::ios::binary);
+	AssertOutputIsOpen(file, fileName);
+
+	const SymbolTable* tables[] = { &m_states, &m_inputs, &m_outputs };
+
+	BinaryFormat::Header header{};
+	header.magic = BinaryFormat::MAGIC;
+	header.version = BinaryFormat::VERSION;
+	header.byteOrderMark = BinaryFormat::BYTE_ORDER_MARK;
+	header.kind = kind;
+	header.stateCount = static_cast<uint32_t>(m_states.Size());
+	header.inputCount = static_cast<uint32_t>(m_inputs.Size());
+	header.outputCount = static_cast<uint32_t>(m_outputs.Size());
+	header.stateOutputCount = static_cast<uint32_t>(stateOutputs.size());
+	header.initialState = m_initialState;
+	header.byteClassCount = static_cast<uint32_t>(m_byteClasses.size());
+	for (const auto& edges : m_edges)
+	{
+		header.edgeCount += edges.size();
+	}
+	for (const auto* table : tables)
+	{
+		for (const auto& name : table->GetNames())
+		{
+			header.nameBytes += name.size();
+		}
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	BinaryFormat::Writer writer(file);
+	uint64_t offset = 0;
+	writer.Write(&offset, sizeof(offset));
+	for (const auto* table : tables)
+	{
+		for (const auto& name : table->GetNames())
+		{
+			offset += name.size();
+			writer.Write(&offset, sizeof(offset));
+		}
+	}
+	writer.EndSection();
+
+	writer.Write(stateOutputs.data(), stateOutputs.size_bytes());
+	writer.EndSection();
+
+	writer.Write(m_byteClasses.data(), m_byteClasses.size() * sizeof(InputId));
+	writer.EndSection();
+
+	uint64_t firstEdge = 0;
+	writer.Write(&firstEdge, sizeof(firstEdge));
+	for (const auto& edges : m_edges)
+	{
+		firstEdge += edges.size();
+		writer.Write(&firstEdge, sizeof(firstEdge));
+	}
+	writer.EndSection();
+
+	for (const auto& edges : m_edges)
+	{
+		writer.Write(edges.data(), edges.size() * sizeof(Edge));
+	}
+	writer.EndSection();
+
+	for (const auto* table : tables)
+	{
+		for (const auto& name : table->GetNames())
+		{
+			writer.Write(name.data(), name.size());
+		}
+	}
+	header.checksum = writer.Finish();
+
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	if (!file)
+	{
+		throw std::runtime_error("Cannot write file: " + fileName);
+	}
+}
+
+std::vector<Machine::OutputId> Machine::ReadBinary(const std::string& fileName, const BinaryFormat::MachineKind kind)
+{
+	using namespace BinaryFormat;
+
+	const MappedFile file(fileName);
+	const auto text = file.GetText();
+	const auto makeError = [&](const std::string& reason) {
+		return std::runtime_error("Invalid machine file " + fileName + ": " + reason);
+	};
+
+	Header header;
+	if (text.size() < sizeof(header))
+	{
+		throw makeError("the file is too short");
+	}
+	std::memcpy(&header, text.data(), sizeof(header));
+	if (header.magic != MAGIC)
+	{
+		throw makeError("not a binary machine file");
+	}
+	if (header.byteOrderMark != BYTE_ORDER_MARK)
+	{
+		throw makeError("written with another byte order");
+	}
+	if (header.version != VERSION)
+	{
+		throw makeError("unsupported version " + std::to_string(header.version));
+	}
+	if (header.kind != kind)
+	{
+		throw makeError(header.kind == MachineKind::MOORE ? "it holds a Moore machine" : "it holds a Mealy machine");
+	}
+	if (header.stateOutputCount != (kind == MachineKind::MOORE ? header.stateCount : 0))
+	{
+		throw makeError("wrong number of state outputs");
+	}
+	if (header.byteClassCount != 0 && header.byteClassCount != BYTE_COUNT)
+	{
+		throw makeError("wrong number of byte classes");
+	}
+	if (reinterpret_cast<uintptr_t>(text.data()) % ALIGNMENT != 0)
+	{
+		throw makeError("the file is not aligned in memory");
+	}
+
+	const size_t nameCount = size_t{ header.stateCount } + header.inputCount + header.outputCount;
+	if (header.edgeCount > text.size() / sizeof(Edge) || header.nameBytes > text.size())
+	{
+		throw makeError("unexpected file size");
+	}
+	const size_t nameOffsetsSize = Align((nameCount + 1) * sizeof(uint64_t));
+	const size_t stateOutputsSize = Align(header.stateOutputCount * sizeof(OutputId));
+	const size_t byteClassesSize = Align(header.byteClassCount * sizeof(InputId));
+	const size_t firstEdgesSize = Align((size_t{ header.stateCount } + 1) * sizeof(uint64_t));
+	const size_t edgesSize = Align(header.edgeCount * sizeof(Edge));
+	const size_t bodySize
+		= nameOffsetsSize + stateOutputsSize + byteClassesSize + firstEdgesSize + edgesSize + Align(header.nameBytes);
+	if (sizeof(header) + bodySize != text.size())
+	{
+		throw makeError("unexpected file size");
+	}
+
+	const auto* body = reinterpret_cast<const std::byte*>(text.data()) + sizeof(header);
+	Checksum checksum;
+	checksum.Update({ body, bodySize });
+	if (checksum.GetValue() != header.checksum)
+	{
+		throw makeError("checksum mismatch");
+	}
+
+	const auto* nameOffsets = reinterpret_cast<const uint64_t*>(body);
+	const auto* stateOutputs = reinterpret_cast<const OutputId*>(body + nameOffsetsSize);
+	const auto* byteClasses = reinterpret_cast<const InputId*>(body + nameOffsetsSize + stateOutputsSize);
+	const auto* firstEdges = reinterpret_cast<const uint64_t*>(body + nameOffsetsSize + stateOutputsSize + byteClassesSize);
+	const auto* edges = reinterpret_cast<const Edge*>(body + nameOffsetsSize + stateOutputsSize + byteClassesSize + firstEdgesSize);
+	const auto* names = reinterpret_cast<const char*>(
+		body + nameOffsetsSize + stateOutputsSize + byteClassesSize + firstEdgesSize + edgesSize);
+
+	if (nameOffsets[0] != 0 || nameOffsets[nameCount] != header.nameBytes
+		|| !std::is_sorted(nameOffsets, nameOffsets + nameCount + 1))
+	{
+		throw makeError("broken name table");
+	}
+	if (firstEdges[0] != 0 || firstEdges[header.stateCount] != header.edgeCount
+		|| !std::is_sorted(firstEdges, firstEdges + header.stateCount + 1))
+	{
+		throw makeError("broken edge table");
+	}
+	const auto isValid = [](const SymbolTable::Id id, const uint32_t count) {
+		return id < count || id == NO_ID;
+	};
+	for (size_t i = 0; i < header.edgeCount; ++i)
+	{
+		const auto& edge = edges[i];
+		if (edge.to >= header.stateCount
+			|| !(isValid(edge.input, header.inputCount) || edge.input == EPSILON_ID)
+			|| !isValid(edge.output, header.outputCount))
+		{
+			throw makeError("edge out of range");
+		}
+	}
+	for (size_t i = 0; i < header.stateOutputCount; ++i)
+	{
+		if (!isValid(stateOutputs[i], header.outputCount))
+		{
+			throw makeError("state output out of range");
+		}
+	}
+	for (size_t i = 0; i < header.byteClassCount; ++i)
+	{
+		if (!isValid(byteClasses[i], header.inputCount))
+		{
+			throw makeError("byte class out of range");
+		}
+	}
+	if (!isValid(header.initialState, header.stateCount))
+	{
+		throw makeError("initial state out of range");
+	}
+
+	ClearMachine();
+	SymbolTable* tables[] = { &m_states, &m_inputs, &m_outputs };
+	const uint32_t counts[] = { header.stateCount, header.inputCount, header.outputCount };
+	size_t nameIndex = 0;
+	for (size_t i = 0; i < std::size(tables); ++i)
+	{
+		tables[i]->Reserve(counts[i]);
+		for (SymbolTable::Id id = 0; id < counts[i]; ++id, ++nameIndex)
+		{
+			const auto offset = nameOffsets[nameIndex];
+			const std::string_view name(names + offset, nameOffsets[nameIndex + 1] - offset);
+			if (tables[i]->Intern(name) != id)
+			{
+				ClearMachine();
+				throw makeError("duplicate name " + std::string(name));
+			}
+		}
+	}
+
+	m_edges.resize(header.stateCount);
+	for (StateId state = 0; state < header.stateCount; ++state)
+	{
+		m_edges[state].assign(edges + firstEdges[state], edges + firstEdges[state + 1]);
+	}
+	m_byteClasses.assign(byteClasses, byteClasses + header.byteClassCount);
+	m_initialState = header.initialState;
+	m_currentState = m_initialState;
+
+	return { stateOutputs, stateOutputs + header.stateOutputCount };
+}
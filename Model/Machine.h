@@ -1,10 +1,41 @@
 #pragma once
 
+#include "BinaryFormat.h"
+#include "DotParser.h"
+#include "DotWriter.h"
+#include "EpsilonClosureIndex.h"
+#include "MachineExecutor.h"
+#include "SymbolTable.h"
+#include "TransitionTable.h"
+
 #include <fstream>
+#include <functional>
 #include <memory>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+enum class MinimizationAlgorithm
+{
+	MOORE_REFINEMENT,
+	HOPCROFT
+};
+
+struct MinimizeOptions
+{
+	MinimizationAlgorithm algorithm = MinimizationAlgorithm::HOPCROFT;
+	// Threads used by MOORE_REFINEMENT, zero means one per hardware core.
+	size_t threadCount = 1;
+};
+
+struct DotOptions
+{
+	// Writes one edge labelled "a,b,c" per pair of states instead of one edge per input. Such
+	// edges carry merged=true, the readers split only their labels.
+	bool mergeParallelEdges = false;
+};
+
 class Machine
 {
 public:
@@ -12,28 +43,66 @@ public:
 	using Input = std::string;
 	using Output = std::string;
 
+	using StateId = SymbolTable::Id;
+	using InputId = SymbolTable::Id;
+	using OutputId = SymbolTable::Id;
+
+	static constexpr SymbolTable::Id NO_ID = SymbolTable::NO_ID;
+	static constexpr InputId EPSILON_ID = NO_ID - 1;
+	static constexpr size_t BYTE_COUNT = 256;
+
 	virtual void FromDot(const std::string& fileName) = 0;
-	virtual void SaveToDot(const std::string& fileName) = 0;
+	virtual void SaveToDot(const std::string& fileName, const DotOptions& options = {}) = 0;
+	virtual void FromBinary(const std::string& fileName) = 0;
+	virtual void SaveToBinary(const std::string& fileName) = 0;
 	virtual bool HasTransition(const State& from, const Input& input) const= 0;
-	virtual std::unique_ptr<Machine> GetMinimized() const = 0;
+	virtual std::unique_ptr<Machine> GetMinimized(const MinimizeOptions& options = {}) const = 0;
 	virtual State GetNextState(const State& fromState, const Input& input) const = 0;
 	virtual State GetInitialState() const = 0;
+	virtual TransitionTable Compile() const = 0;
+
+	// Compiles the machine into the fastest engine for its size, call it on GetMinimized() output
+	// so small languages get down to the shuffle engine.
+	MachineExecutor CompileExecutor() const
+	{
+		return MachineExecutor(Compile());
+	}
 
 	const std::vector<Input>& GetInputs() const
 	{
-		return m_inputs;
+		return m_inputs.GetNames();
 	}
 
 	const std::vector<Output>& GetOutputs() const
 	{
-		return m_outputs;
+		return m_outputs.GetNames();
 	}
 
 	const std::vector<State>& GetStates() const
 	{
-		return m_states;
+		return m_states.GetNames();
+	}
+
+	// Id of the input in the compiled table, the position in GetInputs() or NO_ID for unknown inputs.
+	// Single bytes merged into a class by CompressInputs give the id of their class.
+	InputId GetInputId(const Input& input) const
+	{
+		return input.empty() ? NO_ID : FindInput(input);
+	}
+
+	// Input class of every byte after CompressInputs, NO_ID for bytes outside the alphabet.
+	// Empty for machines whose inputs were never compressed.
+	const std::vector<InputId>& GetByteClasses() const
+	{
+		return m_byteClasses;
 	}
 
+	// Merges the inputs named by single bytes that lead every state to the same states with the
+	// same outputs into one input named like "0-9|a-c", so tables and the loops over inputs shrink.
+	// The byte class map keeps the bytes usable as inputs, GetDeterministic and GetMinimized pass
+	// it on and compress their results again. Returns the input count.
+	size_t CompressInputs();
+
 	void AssertInputIsOpen(const std::ifstream& file, const std::string& fileName)
 	{
 		if (!file.is_open())
@@ -52,10 +121,96 @@ public:
 	virtual ~Machine() = default;
 
 protected:
-	std::vector<std::vector<State>> BreakForPartitions(
-		const std::vector<std::vector<State>>& initialPartitions) const;
+	struct Edge
+	{
+		InputId input;
+		StateId to;
+		OutputId output;
+	};
+
+	using Partitions = std::vector<std::vector<StateId>>;
+
+	Partitions RefinePartitions(
+		const TransitionTable& table,
+		const Partitions& initialPartitions,
+		const MinimizeOptions& options) const;
+
+	// Reference algorithm: refines every group by its transition signature until nothing changes.
+	Partitions BreakForPartitions(const TransitionTable& table, const Partitions& initialPartitions) const;
+
+	// Same rounds as BreakForPartitions with signatures and splits spread over a thread pool.
+	Partitions BreakForPartitionsParallel(
+		const TransitionTable& table,
+		const Partitions& initialPartitions,
+		size_t threadCount) const;
+
+	// Hopcroft's algorithm in Valmari's form for partial transition functions, O(m log n).
+	Partitions BreakForPartitionsHopcroft(const TransitionTable& table, const Partitions& initialPartitions) const;
+
+	// Next states of a deterministic machine, outputs are filled by the concrete machine.
+	TransitionTable CompileTransitions() const;
+
+	StateId AddState(std::string_view state);
+
+	InputId AddInput(std::string_view input);
+
+	StateId FindState(std::string_view state) const;
+
+	InputId FindInput(std::string_view input) const;
+
+	std::string GetStateName(StateId state) const;
+
+	std::string GetInputName(InputId input) const;
+
+	bool HasEdge(StateId from, InputId input) const;
+
+	StateId GetNextStateId(StateId from, InputId input) const;
+
+	std::vector<bool> GetReachableStates() const;
+
+	EpsilonClosureIndex BuildEpsilonClosureIndex() const;
+
+	// Drops states that are not kept and renumbers the rest, returns the old id to new id map.
+	std::vector<StateId> CompactStates(const std::vector<bool>& keep);
+
+	// Position of every output in the alphabetical order of names, used to keep partitions ordered by name.
+	std::vector<OutputId> GetOutputRanks() const;
+
+	void ClearMachine();
+
+	// Takes over the byte classes of the machine this one was derived from and compresses again.
+	void InheritByteClasses(const Machine& source);
+
+	// Name of the input read by the given sorted bytes, the byte itself or ranges and bytes like "0-9|a-c|_".
+	static Input GetBytesName(const std::vector<unsigned char>& bytes);
+
+	using DotNodeHandler = std::function<void(StateId state, const DotStatement& statement)>;
+	using DotEdgeHandler = std::function<void(StateId from, StateId to, const DotStatement& statement)>;
+
+	// Reads states, edges and the initial state from a DOT file, labels are left to the handlers.
+	// The initial state is the last doublecircle node, else the target of a point shaped marker
+	// node such as "__initial__ -> S0", else the first state.
+	void LoadDot(const std::string& fileName, const DotNodeHandler& onNode, const DotEdgeHandler& onEdge);
+
+	using DotLabelWriter = std::function<void(DotWriter& writer, const Edge& edge)>;
+
+	// Writes all edges in state and insertion order, merged ones keep the order of their first edge.
+	void WriteDotEdges(DotWriter& writer, const DotOptions& options, const DotLabelWriter& writeLabel) const;
+
+	// Writes names, the initial state and the edges, state outputs are empty for Mealy machines.
+	void WriteBinary(
+		const std::string& fileName,
+		BinaryFormat::MachineKind kind,
+		std::span<const OutputId> stateOutputs);
+
+	// Replaces names, the initial state and the edges with the file contents and returns the state outputs.
+	std::vector<OutputId> ReadBinary(const std::string& fileName, BinaryFormat::MachineKind kind);
 
-	std::vector<State> m_states;
-	std::vector<Input> m_inputs;
-	std::vector<Output> m_outputs;
+	SymbolTable m_states;
+	SymbolTable m_inputs;
+	SymbolTable m_outputs;
+	std::vector<std::vector<Edge>> m_edges;
+	std::vector<InputId> m_byteClasses;
+	StateId m_initialState = NO_ID;
+	StateId m_currentState = NO_ID;
 };
@@ -0,0 +1,459 @@
+#include "MachineExecutor.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SHUFFLE_TARGET __attribute__((target("ssse3")))
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SHUFFLE_TARGET
+#endif
+
+namespace
+{
+// Inputs consumed between dead state checks when input pairs are composed.
+constexpr size_t PAIR_BLOCK = 32;
+// Pair rows take inputCount squared rows, beyond this they stop fitting in the L1 cache.
+constexpr size_t MAX_PAIR_INPUTS = 16;
+// Inputs a chunk gets at least, shorter inputs are not worth the threads.
+constexpr size_t MIN_PARALLEL_CHUNK = 1 << 16;
+// Machines up to this size run a chunk from every state, larger ones from guessed states.
+constexpr size_t MAX_ENUMERATED_STATES = 64;
+// Inputs before a chunk replayed to guess the states it starts in.
+constexpr size_t LOOK_BACK = 1024;
+// Steps between merges of chunk paths that reached the same state.
+constexpr size_t MERGE_INTERVAL = 16;
+// Steps after which paths that never merged into one are given up, the chunk then runs in the stitch.
+constexpr size_t MERGE_BUDGET = 1 << 12;
+
+using RunResult = TransitionTable::RunResult;
+
+// Merges the live paths that are in the same state, returns how many live paths are left.
+size_t MergePaths(std::vector<RunResult>& ends, std::vector<size_t>& startEnds)
+{
+	std::vector<size_t> order(ends.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](const size_t left, const size_t right) {
+		return std::make_pair(ends[left].IsRejected(), ends[left].state)
+			< std::make_pair(ends[right].IsRejected(), ends[right].state);
+	});
+
+	std::vector<RunResult> merged;
+	std::vector<size_t> newIndex(ends.size());
+	size_t liveCount = 0;
+	for (const auto index : order)
+	{
+		const auto& end = ends[index];
+		if (end.IsRejected() || merged.empty() || merged.back().IsRejected() || merged.back().state != end.state)
+		{
+			merged.push_back(end);
+			liveCount += !end.IsRejected();
+		}
+		newIndex[index] = merged.size() - 1;
+	}
+	for (auto& end : startEnds)
+	{
+		end = newIndex[end];
+	}
+	ends.swap(merged);
+	return liveCount;
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+using StateVector = __m128i;
+
+bool IsShuffleSupported()
+{
+	return __builtin_cpu_supports("ssse3");
+}
+
+SHUFFLE_TARGET inline StateVector Broadcast(const std::uint8_t state)
+{
+	return _mm_set1_epi8(static_cast<char>(state));
+}
+
+// Every lane holds the same state, so lane i of the result is row[state].
+SHUFFLE_TARGET inline StateVector Step(const std::uint8_t* row, const StateVector states)
+{
+	return _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(row)), states);
+}
+
+SHUFFLE_TARGET inline std::uint8_t FirstLane(const StateVector states)
+{
+	return static_cast<std::uint8_t>(_mm_cvtsi128_si32(states));
+}
+#elif defined(__aarch64__)
+using StateVector = uint8x16_t;
+
+bool IsShuffleSupported()
+{
+	return true;
+}
+
+inline StateVector Broadcast(const std::uint8_t state)
+{
+	return vdupq_n_u8(state);
+}
+
+inline StateVector Step(const std::uint8_t* row, const StateVector states)
+{
+	return vqtbl1q_u8(vld1q_u8(row), states);
+}
+
+inline std::uint8_t FirstLane(const StateVector states)
+{
+	return vgetq_lane_u8(states, 0);
+}
+#else
+bool IsShuffleSupported()
+{
+	return false;
+}
+#endif
+} // namespace
+
+MachineExecutor::MachineExecutor(TransitionTable table)
+	: m_table(std::move(table))
+{
+	const auto stateCount = m_table.GetStateCount();
+	const auto inputCount = m_table.GetInputCount();
+	if (stateCount == 0 || stateCount > MAX_SHUFFLE_STATES || !IsShuffleSupported())
+	{
+		return;
+	}
+
+	bool hasMissing = false;
+	for (Id state = 0; state < stateCount; ++state)
+	{
+		for (Id input = 0; input < inputCount; ++input)
+		{
+			hasMissing = hasMissing || m_table.GetNextState(state, input) == TransitionTable::NO_ID;
+		}
+	}
+	if (hasMissing && stateCount == MAX_SHUFFLE_STATES)
+	{
+		return;
+	}
+	// A complete machine with 16 states never reaches the dead state, 0xFF matches no lane then.
+	m_deadState = stateCount < MAX_SHUFFLE_STATES ? static_cast<std::uint8_t>(stateCount) : 0xFF;
+
+	m_rows.resize(inputCount);
+	for (Id input = 0; input < inputCount; ++input)
+	{
+		auto& next = m_rows[input].next;
+		next.fill(m_deadState == 0xFF ? 0 : m_deadState);
+		for (Id state = 0; state < stateCount; ++state)
+		{
+			const auto nextState = m_table.GetNextState(state, input);
+			if (nextState != TransitionTable::NO_ID)
+			{
+				next[state] = static_cast<std::uint8_t>(nextState);
+			}
+		}
+	}
+
+	if (inputCount > MAX_PAIR_INPUTS)
+	{
+		return;
+	}
+	m_pairRows.resize(inputCount * inputCount);
+	for (Id first = 0; first < inputCount; ++first)
+	{
+		for (Id second = 0; second < inputCount; ++second)
+		{
+			auto& next = m_pairRows[first * inputCount + second].next;
+			for (size_t state = 0; state < MAX_SHUFFLE_STATES; ++state)
+			{
+				next[state] = m_rows[second].next[m_rows[first].next[state]];
+			}
+		}
+	}
+}
+
+MachineExecutor::RunResult MachineExecutor::Run(const Id state, const std::span<const Id> inputs, const std::span<Id> outputs) const
+{
+	if (m_rows.empty())
+	{
+		return m_table.Run(state, inputs, outputs);
+	}
+	if (!outputs.empty() && outputs.size() < inputs.size())
+	{
+		throw std::runtime_error("The output buffer is shorter than the input.");
+	}
+	if (state >= m_table.GetStateCount())
+	{
+		return { state, 0 };
+	}
+	return RunShuffles(state, inputs, outputs);
+}
+
+void MachineExecutor::RunStreams(
+	const Id state,
+	const std::span<const std::span<const Id>> streams,
+	const std::span<RunResult> results) const
+{
+	if (m_rows.empty())
+	{
+		m_table.RunStreams(state, streams, results);
+		return;
+	}
+	if (results.size() < streams.size())
+	{
+		throw std::runtime_error("The result buffer is shorter than the list of streams.");
+	}
+	// The rows stay in registers and the cache, so one stream after another is already fast.
+	for (size_t i = 0; i < streams.size(); ++i)
+	{
+		results[i] = Run(state, streams[i], {});
+	}
+}
+
+MachineExecutor::RunResult MachineExecutor::RunParallel(
+	const Id state,
+	const std::span<const Id> inputs,
+	const std::span<Id> outputs,
+	const size_t threadCount) const
+{
+	if (!outputs.empty() && outputs.size() < inputs.size())
+	{
+		throw std::runtime_error("The output buffer is shorter than the input.");
+	}
+	const auto stateCount = m_table.GetStateCount();
+	const auto chunkCount = std::min(ThreadPool::ResolveThreadCount(threadCount), inputs.size() / MIN_PARALLEL_CHUNK);
+	if (chunkCount <= 1 || state >= stateCount)
+	{
+		return Run(state, inputs, outputs);
+	}
+
+	const auto chunkBegin = [&](const size_t chunk) {
+		return inputs.size() * chunk / chunkCount;
+	};
+	const auto chunkInputs = [&](const size_t chunk) {
+		return inputs.subspan(chunkBegin(chunk), chunkBegin(chunk + 1) - chunkBegin(chunk));
+	};
+	const auto chunkOutputs = [&](const size_t chunk) {
+		return outputs.empty() ? outputs : outputs.subspan(chunkBegin(chunk), chunkBegin(chunk + 1) - chunkBegin(chunk));
+	};
+
+	RunResult first;
+	std::vector<ChunkPaths> chunkPaths(chunkCount);
+	ThreadPool pool(chunkCount);
+	pool.Run(chunkCount, [&](const size_t chunk) {
+		if (chunk == 0)
+		{
+			first = Run(state, chunkInputs(0), chunkOutputs(0));
+			return;
+		}
+
+		auto& paths = chunkPaths[chunk];
+		if (stateCount <= MAX_ENUMERATED_STATES)
+		{
+			paths.starts.resize(stateCount);
+			std::iota(paths.starts.begin(), paths.starts.end(), 0);
+		}
+		else
+		{
+			// Most inputs synchronize a machine within a few symbols, so the states the inputs just
+			// before the chunk lead to are likely starts whatever the state before them was.
+			const auto lookBack = inputs.subspan(chunkBegin(chunk) - LOOK_BACK, LOOK_BACK);
+			paths.starts.push_back(state);
+			for (const auto seed : { state, m_table.GetInitialState() })
+			{
+				const auto guess = seed < stateCount ? Run(seed, lookBack, {}) : RunResult{ seed, 0 };
+				if (!guess.IsRejected())
+				{
+					paths.starts.push_back(guess.state);
+				}
+			}
+		}
+		RunChunkPaths(paths, chunkInputs(chunk), chunkOutputs(chunk));
+	});
+
+	if (first.IsRejected())
+	{
+		return first;
+	}
+	auto current = first.state;
+	for (size_t chunk = 1; chunk < chunkCount; ++chunk)
+	{
+		const auto& paths = chunkPaths[chunk];
+		const auto begin = chunkBegin(chunk);
+		const auto start = std::find(paths.starts.begin(), paths.starts.end(), current);
+		const bool isKnown = start != paths.starts.end()
+			&& (outputs.empty() || paths.mergedAt != ChunkPaths::NOT_MERGED);
+		if (!isKnown)
+		{
+			const auto result = Run(current, chunkInputs(chunk), chunkOutputs(chunk));
+			if (result.IsRejected())
+			{
+				return { result.state, begin + result.rejectedAt };
+			}
+			current = result.state;
+			continue;
+		}
+
+		if (!outputs.empty() && paths.mergedAt > 0)
+		{
+			// Rejections before the merge show up here, the paths only kept the live ones merged.
+			const auto result = Run(current, chunkInputs(chunk).first(paths.mergedAt), chunkOutputs(chunk).first(paths.mergedAt));
+			if (result.IsRejected())
+			{
+				return { result.state, begin + result.rejectedAt };
+			}
+		}
+		const auto& end = paths.ends[paths.startEnds[start - paths.starts.begin()]];
+		if (end.IsRejected())
+		{
+			return { end.state, begin + end.rejectedAt };
+		}
+		current = end.state;
+	}
+	return { current };
+}
+
+void MachineExecutor::RunChunkPaths(ChunkPaths& paths, const std::span<const Id> chunk, const std::span<Id> outputs) const
+{
+	const auto inputCount = m_table.GetInputCount();
+	for (const auto start : paths.starts)
+	{
+		paths.startEnds.push_back(paths.ends.size());
+		paths.ends.push_back({ start });
+	}
+
+	auto liveCount = MergePaths(paths.ends, paths.startEnds);
+	for (size_t offset = 0; liveCount > 0;)
+	{
+		if (liveCount == 1)
+		{
+			auto& end = *std::find_if(paths.ends.begin(), paths.ends.end(), [](const RunResult& end) {
+				return !end.IsRejected();
+			});
+			const auto result = Run(end.state, chunk.subspan(offset), outputs.empty() ? outputs : outputs.subspan(offset));
+			end = { result.state, result.IsRejected() ? offset + result.rejectedAt : RunResult::NOT_REJECTED };
+			paths.mergedAt = offset;
+			return;
+		}
+		if (offset == chunk.size())
+		{
+			return;
+		}
+		if (offset >= MERGE_BUDGET)
+		{
+			paths.starts.clear();
+			return;
+		}
+
+		const auto stop = std::min(chunk.size(), offset + MERGE_INTERVAL);
+		for (; offset < stop; ++offset)
+		{
+			const auto input = chunk[offset];
+			for (auto& end : paths.ends)
+			{
+				if (end.IsRejected())
+				{
+					continue;
+				}
+				const auto nextState = input < inputCount ? m_table.GetNextState(end.state, input) : TransitionTable::NO_ID;
+				if (nextState == TransitionTable::NO_ID)
+				{
+					end.rejectedAt = offset;
+				}
+				else
+				{
+					end.state = nextState;
+				}
+			}
+		}
+		liveCount = MergePaths(paths.ends, paths.startEnds);
+	}
+}
+
+#if defined(SHUFFLE_TARGET)
+SHUFFLE_TARGET MachineExecutor::RunResult MachineExecutor::RunShuffles(
+	const Id state,
+	const std::span<const Id> inputs,
+	const std::span<Id> outputs) const
+{
+	const auto inputCount = m_table.GetInputCount();
+	const auto deadState = m_deadState;
+	const auto* rows = m_rows.data();
+	auto states = Broadcast(static_cast<std::uint8_t>(state));
+	size_t i = 0;
+
+	// The shuffle chain is the only dependency between steps: the row address depends on the
+	// input alone, and the dead state checks run beside it. A block that rejects or holds an
+	// unknown input is left to the single step loop, which finds the exact position.
+	if (outputs.empty() && !m_pairRows.empty())
+	{
+		const auto* pairRows = m_pairRows.data();
+		for (; i + PAIR_BLOCK <= inputs.size(); i += PAIR_BLOCK)
+		{
+			const auto* block = inputs.data() + i;
+			Id largest = 0;
+			for (size_t j = 0; j < PAIR_BLOCK; ++j)
+			{
+				largest = std::max(largest, block[j]);
+			}
+			if (largest >= inputCount)
+			{
+				break;
+			}
+
+			auto blockStates = states;
+			for (size_t j = 0; j < PAIR_BLOCK; j += 2)
+			{
+				blockStates = Step(pairRows[block[j] * inputCount + block[j + 1]].next.data(), blockStates);
+			}
+			if (FirstLane(blockStates) == deadState)
+			{
+				break;
+			}
+			states = blockStates;
+		}
+	}
+
+	const bool writeStateOutputs = !outputs.empty() && m_table.HasStateOutputs();
+	const bool writeTransitionOutputs = !outputs.empty() && m_table.HasTransitionOutputs();
+	Id current = FirstLane(states);
+	for (; i < inputs.size(); ++i)
+	{
+		const auto input = inputs[i];
+		if (input >= inputCount)
+		{
+			return { current, i };
+		}
+		const auto nextStates = Step(rows[input].next.data(), states);
+		const Id nextState = FirstLane(nextStates);
+		if (nextState == deadState)
+		{
+			return { current, i };
+		}
+
+		if (writeTransitionOutputs)
+		{
+			outputs[i] = m_table.GetTransitionOutput(current, input);
+		}
+		else if (writeStateOutputs)
+		{
+			outputs[i] = m_table.GetStateOutput(nextState);
+		}
+		states = nextStates;
+		current = nextState;
+	}
+	return { current };
+}
+#else
+MachineExecutor::RunResult MachineExecutor::RunShuffles(
+	const Id state,
+	const std::span<const Id> inputs,
+	const std::span<Id> outputs) const
+{
+	// Never reached, the constructor only fills the rows where shuffles exist.
+	return m_table.Run(state, inputs, outputs);
+}
+#endif
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "TransitionTable.h"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Runs a compiled deterministic machine with the fastest engine that fits it.
+// Machines with at most 16 states, counting an extra dead state when some
+// transitions are missing, keep one 16 byte row of next states per input and
+// step with a byte shuffle instead of a dependent load. When no outputs are
+// requested, rows of input pairs are composed up front so a shuffle consumes
+// two inputs. Larger machines, and CPUs without byte shuffles, use the table.
+class MachineExecutor
+{
+public:
+	using Id = TransitionTable::Id;
+	using RunResult = TransitionTable::RunResult;
+
+	static constexpr size_t MAX_SHUFFLE_STATES = 16;
+
+	explicit MachineExecutor(TransitionTable table);
+
+	// Same contract as TransitionTable::Run.
+	RunResult Run(Id state, std::span<const Id> inputs, std::span<Id> outputs) const;
+
+	// Same contract as TransitionTable::RunStreams.
+	void RunStreams(Id state, std::span<const std::span<const Id>> streams, std::span<RunResult> results) const;
+
+	// Same result and outputs as Run, for one long input split into a chunk per thread. The chunks
+	// after the first do not know their start state, so each runs from every state of a small
+	// machine, or from the states a short look back guesses, merging paths as they meet. The
+	// chunks are then chained through those paths; a chunk whose real start state was not tried,
+	// or whose outputs depend on it, runs again where the chain reaches it. Outputs past a
+	// rejection may hold what later chunks wrote. Zero threads means one per hardware core.
+	RunResult RunParallel(Id state, std::span<const Id> inputs, std::span<Id> outputs, size_t threadCount = 0) const;
+
+	bool UsesShuffles() const
+	{
+		return !m_rows.empty();
+	}
+
+	const TransitionTable& GetTable() const
+	{
+		return m_table;
+	}
+
+private:
+	struct alignas(16) Row
+	{
+		std::array<std::uint8_t, MAX_SHUFFLE_STATES> next;
+	};
+
+	// Paths of one chunk from every tried start state. Paths that reach the same state merge, so
+	// once a single path is left the outputs of the rest of the chunk no longer depend on the start.
+	struct ChunkPaths
+	{
+		static constexpr size_t NOT_MERGED = RunResult::NOT_REJECTED;
+
+		std::vector<Id> starts;
+		// Index into ends for every start.
+		std::vector<size_t> startEnds;
+		// Last state of every path, rejectedAt counts from the chunk start.
+		std::vector<RunResult> ends;
+		// Offset from which one path was left and the outputs were written.
+		size_t mergedAt = NOT_MERGED;
+	};
+
+	RunResult RunShuffles(Id state, std::span<const Id> inputs, std::span<Id> outputs) const;
+
+	void RunChunkPaths(ChunkPaths& paths, std::span<const Id> chunk, std::span<Id> outputs) const;
+
+	TransitionTable m_table;
+	// Next state of every state per input, missing transitions and unused lanes lead to the dead state.
+	std::vector<Row> m_rows;
+	// Rows for input a followed by input b at a * inputCount + b, only for small alphabets.
+	std::vector<Row> m_pairRows;
+	std::uint8_t m_deadState = 0;
+};
@@ -0,0 +1,121 @@
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& fileName)
+{
+	std::ifstream file(fileName, std::ios::binary);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Cannot open file: " + fileName);
+	}
+	m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	m_data = m_buffer.data();
+	m_size = m_buffer.size();
+}
+
+MappedFile::~MappedFile() = default;
+
+#else
+
+namespace
+{
+constexpr size_t READ_BLOCK_SIZE = 1 << 16;
+} // namespace
+
+MappedFile::MappedFile(const std::string& fileName)
+{
+	if (fileName == "-")
+	{
+		ReadAll(STDIN_FILENO, fileName);
+		return;
+	}
+
+	const int descriptor = open(fileName.c_str(), O_RDONLY);
+	if (descriptor < 0)
+	{
+		throw std::runtime_error("Cannot open file: " + fileName);
+	}
+
+	struct stat status{};
+	if (fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0)
+	{
+		const auto size = static_cast<size_t>(status.st_size);
+		void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (mapping != MAP_FAILED)
+		{
+			madvise(mapping, size, MADV_SEQUENTIAL);
+			m_mapping = mapping;
+			m_data = static_cast<const char*>(mapping);
+			m_size = size;
+			close(descriptor);
+			return;
+		}
+	}
+
+	try
+	{
+		ReadAll(descriptor, fileName);
+	}
+	catch (...)
+	{
+		close(descriptor);
+		throw;
+	}
+	close(descriptor);
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_mapping != nullptr)
+	{
+		munmap(m_mapping, m_size);
+	}
+}
+
+void MappedFile::ReadAll(const int descriptor, const std::string& fileName)
+{
+	size_t size = 0;
+	while (true)
+	{
+		if (m_buffer.size() - size < READ_BLOCK_SIZE)
+		{
+			m_buffer.resize(std::max(m_buffer.size() * 2, size + READ_BLOCK_SIZE));
+		}
+
+		const auto count = read(descriptor, m_buffer.data() + size, m_buffer.size() - size);
+		if (count == 0)
+		{
+			break;
+		}
+		if (count < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			throw std::runtime_error("Cannot read file: " + fileName);
+		}
+		size += static_cast<size_t>(count);
+	}
+
+	m_buffer.resize(size);
+	m_data = m_buffer.data();
+	m_size = size;
+}
+
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Read only view of a whole input file. Regular files are memory mapped so
+// loaders can keep names as views into the mapping; pipes, character devices
+// and "-" for stdin are read in large blocks into a buffer instead.
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& fileName);
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile();
+
+	std::string_view GetText() const
+	{
+		return { m_data, m_size };
+	}
+
+	bool IsMapped() const
+	{
+		return m_mapping != nullptr;
+	}
+
+private:
+#if !defined(_WIN32)
+	void ReadAll(int descriptor, const std::string& fileName);
+#endif
+
+	const char* m_data = nullptr;
+	size_t m_size = 0;
+	void* m_mapping = nullptr;
+	std::vector<char> m_buffer;
+};
@@ -1,9 +1,10 @@
 #include "MealyMachine.h"
 #include "MooreMachine.h"
+#include <algorithm>
 #include <fstream>
+#include <map>
 #include <queue>
 #include <ranges>
-#include <regex>
 #include <set>
 #include <utility>
 
@@ -17,10 +18,13 @@ std::unique_ptr<MealyMachine> BuildMinimizedMachine(
 	const MealyMachine& machine,
 	const std::vector<std::vector<Machine::State>>& finalPartitions);
 
-MealyMachine::MealyMachine(State initialState)
-	: m_initialState(initialState)
-	, m_currentState(std::move(initialState))
+MealyMachine::MealyMachine(const State& initialState)
 {
+	if (!initialState.empty())
+	{
+		m_initialState = AddState(initialState);
+		m_currentState = m_initialState;
+	}
 }
 
 MealyMachine::MealyMachine(MooreMachine& mooreMachine)
@@ -30,107 +34,81 @@ MealyMachine::MealyMachine(MooreMachine& mooreMachine)
 
 void MealyMachine::FromDot(const std::string& fileName)
 {
-	std::ifstream file(fileName);
-	AssertInputIsOpen(file, fileName);
-
-	const std::regex edgeRegex(R"((\w+)\s*->\s*(\w+)\s*\[label\s*=\s*\"([^/]*)/([^\"]+)\"\]\s*;)");
-	const std::regex digraphRegex(R"(digraph\s+(\w+)\s*\{)");
-	const std::regex initialStateRegex(R"(\s*(\w+)\s*\[.*shape\s*=\s*doublecircle.*\]\s*;)");
-
-	State initialState;
-
 	Clear();
-	m_transitions.clear();
 
-	std::string line;
-	while (std::getline(file, line))
-	{
-		line.erase(0, line.find_first_not_of(" \t"));
-		line.erase(line.find_last_not_of(" \t") + 1);
-
-		if (line.empty() || line.substr(0, 2) == "//")
-		{
-			continue;
-		}
-
-		std::smatch match;
-		if (std::regex_search(line, match, digraphRegex))
+	const auto onEdge = [&](const StateId from, const StateId to, const DotStatement& statement) {
+		const auto label = statement.GetAttribute("label");
+		if (!label)
 		{
-			continue;
+			throw DotParser::MakeError(fileName, statement.line, statement.column, "expected a label of the form \"input/output\"");
 		}
-
-		if (std::regex_search(line, match, edgeRegex))
-		{
-			State fromState = match[1];
-			State toState = match[2];
-			Input input = match[3];
-			Output output = match[4];
-
-			if (!input.empty() && input.front() == '"' && input.back() == '"')
-			{
-				input = input.substr(1, input.length() - 2);
-			}
-			if (!output.empty() && output.front() == '"' && output.back() == '"')
+		const auto addTransition = [&](const std::string_view item) {
+			const auto slash = item.find('/');
+			if (slash == std::string_view::npos)
 			{
-				output = output.substr(1, output.length() - 2);
+				throw DotParser::MakeError(fileName, statement.line, statement.column, "expected a label of the form \"input/output\"");
 			}
-
-			AddTransition(fromState, input, toState, output);
+			const auto input = AddInput(DotParser::Unescape(DotParser::Trim(item.substr(0, slash))));
+			AddTransition(from, input, to, m_outputs.Intern(DotParser::Unescape(DotParser::Trim(item.substr(slash + 1)))));
+		};
+		if (statement.GetAttribute("merged"))
+		{
+			DotParser::SplitList(*label, addTransition);
 		}
-		else if (std::regex_search(line, match, initialStateRegex))
+		else
 		{
-			initialState = match[1];
+			addTransition(*label);
 		}
-	}
-	file.close();
+	};
 
-	if (!initialState.empty())
-	{
-		m_initialState = initialState;
-		m_currentState = initialState;
-	}
-	else if (!m_states.empty())
-	{
-		m_initialState = m_states[0];
-		m_currentState = m_states[0];
-	}
+	LoadDot(fileName, [](StateId, const DotStatement&) {}, onEdge);
 }
 
-void MealyMachine::SaveToDot(const std::string& fileName)
+void MealyMachine::SaveToDot(const std::string& fileName, const DotOptions& options)
 {
-	std::ofstream file(fileName);
-	AssertOutputIsOpen(file, fileName);
+	DotWriter file(fileName);
 
-	file << "digraph MealyMachine {" << std::endl;
-	file << "    rankdir=LR;" << std::endl;
-	file << "    size=\"8,5\"" << std::endl
-		 << std::endl;
+	file << "digraph MealyMachine {\n";
+	file << "    rankdir=LR;\n";
+	file << "    size=\"8,5\"\n\n";
 
-	for (const auto& state : m_states)
+	for (StateId state = 0; state < m_states.Size(); ++state)
 	{
-		file << "    " << state;
+		file << "    " << m_states.GetName(state);
 		if (state == m_initialState)
 		{
 			file << " [shape=doublecircle, color=blue]";
 		}
-		file << ";" << std::endl;
+		file << ";\n";
 	}
-	file << std::endl;
+	file << '\n';
 
-	for (const auto& [fromState, transitions] : m_transitions)
-	{
-		for (const auto& [input, transitionList] : transitions)
+	WriteDotEdges(file, options, [&](DotWriter& writer, const Edge& edge) {
+		if (edge.input == EPSILON_ID)
 		{
-			for (const auto& transition : transitionList)
-			{
-				file << "    " << fromState << " -> " << transition.nextState
-					 << " [label=\"" << (input == EPSILON ? "E" : input)
-					 << "/" << transition.output << "\"];" << std::endl;
-			}
+			writer << "E";
 		}
-	}
+		else
+		{
+			writer.WriteEscaped(m_inputs.GetName(edge.input));
+		}
+		writer << '/';
+		writer.WriteEscaped(m_outputs.GetName(edge.output));
+	});
 
-	file << "}" << std::endl;
+	file << "}\n";
+	file.Close();
+}
+
+void MealyMachine::FromBinary(const std::string& fileName)
+{
+	Clear();
+	ReadBinary(fileName, BinaryFormat::MachineKind::MEALY);
+}
+
+void MealyMachine::SaveToBinary(const std::string& fileName)
+{
+	WriteBinary(fileName, BinaryFormat::MachineKind::MEALY, {});
 }
 
 void MealyMachine::AddTransition(
@@ -139,54 +117,47 @@ void MealyMachine::AddTransition(
 	const State& to,
 	const Output& output)
 {
-	m_transitions[from][input].emplace_back(to, output);
+	const auto fromId = AddState(from);
+	const auto toId = AddState(to);
+	const auto inputId = AddInput(input);
+	AddTransition(fromId, inputId, toId, m_outputs.Intern(output));
+}
 
-	if (std::ranges::find(m_states, from) == m_states.end())
-	{
-		m_states.push_back(from);
-	}
-	if (std::ranges::find(m_states, to) == m_states.end())
-	{
-		m_states.push_back(to);
-	}
-	if (input != EPSILON && std::ranges::find(m_inputs, input) == m_inputs.end())
-	{
-		m_inputs.push_back(input);
-	}
-	if (std::ranges::find(m_outputs, output) == m_outputs.end())
-	{
-		m_outputs.push_back(output);
-	}
+void MealyMachine::AddTransition(const StateId from, const InputId input, const StateId to, const OutputId output)
+{
+	m_edges[from].push_back({ input, to, output });
+}
+
+Machine::StateId MealyMachine::AddGeneratedState()
+{
+	const auto state = static_cast<StateId>(m_edges.size());
+	m_edges.emplace_back();
+	return state;
 }
 
 bool MealyMachine::HasTransition(const State& from, const Input& input) const
 {
-	const auto stateIt = m_transitions.find(from);
-	if (stateIt == m_transitions.end())
-	{
-		return false;
-	}
-	const auto inputIt = stateIt->second.find(input);
-	if (inputIt == stateIt->second.end())
-	{
-		return false;
-	}
-	return !inputIt->second.empty();
+	return HasEdge(FindState(from), FindInput(input));
 }
 
 std::vector<MealyMachine::Transition> MealyMachine::GetTransitions(const State& fromState, const Input& input) const
 {
-	const auto stateIt = m_transitions.find(fromState);
-	if (stateIt == m_transitions.end())
+	const auto from = FindState(fromState);
+	const auto inputId = FindInput(input);
+	if (from == NO_ID || inputId == NO_ID)
 	{
 		return {};
 	}
-	const auto inputIt = stateIt->second.find(input);
-	if (inputIt == stateIt->second.end())
+
+	std::vector<Transition> transitions;
+	for (const auto& edge : m_edges[from])
 	{
-		return {};
+		if (edge.input == inputId)
+		{
+			transitions.emplace_back(m_states.GetName(edge.to), m_outputs.GetName(edge.output));
+		}
 	}
-	return inputIt->second;
+	return transitions;
 }
 
 void MealyMachine::ConvertFromMoore(MooreMachine& moore)
@@ -204,7 +175,7 @@ void MealyMachine::ConvertFromMoore(MooreMachine& moore)
 		return;
 	}
 
-	m_currentState = initialState;
+	m_currentState = AddState(initialState);
 
 	std::queue<State> statesToProcess;
 	std::set<State> visitedStates;
@@ -239,7 +210,7 @@ void MealyMachine::ConvertFromMoore(MooreMachine& moore)
 	}
 }
 
-std::unique_ptr<Machine> MealyMachine::GetMinimized() const
+std::unique_ptr<Machine> MealyMachine::GetMinimized(const MinimizeOptions& options) const
 {
 	MealyMachine machineToMinimize;
 	if (!this->IsDeterministic())
@@ -258,150 +229,87 @@ std::unique_ptr<Machine> MealyMachine::GetMinimized() const
 	}
 
 	machineToMinimize.RemoveUnreachableStates();
-	if (machineToMinimize.m_states.empty())
+	if (machineToMinimize.m_states.Empty())
 	{
 		return std::make_unique<MealyMachine>();
 	}
 
-	std::map<std::vector<Output>, std::vector<State>> initialGroups;
-	for (const auto& state : machineToMinimize.m_states)
+	const auto table = machineToMinimize.Compile();
+	const auto outputRanks = machineToMinimize.GetOutputRanks();
+	std::map<std::vector<OutputId>, std::vector<StateId>> initialGroups;
+	for (StateId state = 0; state < table.GetStateCount(); ++state)
 	{
-		std::vector<Output> outputVector;
-		for (const auto& input : machineToMinimize.m_inputs)
+		std::vector<OutputId> outputVector(table.GetInputCount(), 0);
+		for (InputId input = 0; input < table.GetInputCount(); ++input)
 		{
-			if (machineToMinimize.HasTransition(state, input))
-			{
-				outputVector.push_back(machineToMinimize.GetTransitionOutput(state, input));
-			}
-			else
+			if (table.GetNextState(state, input) != NO_ID)
 			{
-				outputVector.emplace_back("");
+				outputVector[input] = outputRanks[table.GetTransitionOutput(state, input)] + 1;
 			}
 		}
 		initialGroups[outputVector].push_back(state);
 	}
 
-	std::vector<std::vector<State>> partitions;
-	for (const auto& val : initialGroups | std::views::values)
+	Partitions partitions;
+	for (auto& val : initialGroups | std::views::values)
 	{
-		partitions.push_back(val);
+		partitions.push_back(std::move(val));
 	}
 
-	while (true)
-	{
-		std::map<State, int> stateToGroupIndex;
-		for (int i = 0; i < partitions.size(); ++i)
-		{
-			for (const auto& state : partitions[i])
-			{
-				stateToGroupIndex[state] = i;
-			}
-		}
-
-		std::vector<std::vector<State>> newPartitions;
-		bool splitOccurred = false;
-
-		for (const auto& group : partitions)
-		{
-			if (group.size() <= 1)
-			{
-				newPartitions.push_back(group);
-				continue;
-			}
-
-			std::map<std::vector<int>, std::vector<State>> subgroups;
-			for (const auto& state : group)
-			{
-				std::vector<int> transitionSignature;
-				for (const auto& input : machineToMinimize.m_inputs)
-				{
-					if (machineToMinimize.HasTransition(state, input))
-					{
-						State nextState = machineToMinimize.GetNextState(state, input);
-						transitionSignature.push_back(stateToGroupIndex.at(nextState));
-					}
-					else
-					{
-						transitionSignature.push_back(-1);
-					}
-				}
-				subgroups[transitionSignature].push_back(state);
-			}
-
-			if (subgroups.size() > 1)
-			{
-				splitOccurred = true;
-			}
+	partitions = machineToMinimize.RefinePartitions(table, partitions, options);
 
-			for (const auto& val : subgroups | std::views::values)
-			{
-				newPartitions.push_back(val);
-			}
-		}
-
-		partitions = newPartitions;
-
-		if (!splitOccurred)
-		{
-			break;
-		}
-	}
-
-	MealyMachine minimizedMachine;
-	std::unordered_map<State, State> oldStateToNewState;
-	int newStateCounter = 0;
+	auto minimizedMachine = std::make_unique<MealyMachine>();
+	minimizedMachine->m_inputs = machineToMinimize.m_inputs;
+	minimizedMachine->m_outputs = machineToMinimize.m_outputs;
 
+	std::vector<StateId> oldStateToNewState(machineToMinimize.m_states.Size(), NO_ID);
 	for (const auto& group : partitions)
 	{
-		State newStateName = "S" + std::to_string(newStateCounter++);
-		minimizedMachine.m_states.push_back(newStateName);
+		const auto newState = minimizedMachine->AddGeneratedState();
 
-		for (const auto& oldState : group)
+		for (const auto oldState : group)
 		{
-			oldStateToNewState[oldState] = newStateName;
+			oldStateToNewState[oldState] = newState;
 		}
 
 		if (std::ranges::find(group, machineToMinimize.m_initialState) != group.end())
 		{
-			minimizedMachine.m_initialState = newStateName;
-			minimizedMachine.m_currentState = newStateName;
+			minimizedMachine->m_initialState = newState;
+			minimizedMachine->m_currentState = newState;
 		}
 	}
 
 	for (const auto& group : partitions)
 	{
-		State representative = group.front();
-		const State& newFromState = oldStateToNewState.at(representative);
+		StateId representative = group.front();
+		const auto newFromState = oldStateToNewState[representative];
 
-		for (const auto& input : machineToMinimize.m_inputs)
+		for (InputId input = 0; input < table.GetInputCount(); ++input)
 		{
-			if (!machineToMinimize.HasTransition(representative, input))
-			{
-				continue;
-			}
-
-			State oldToState = machineToMinimize.GetNextState(representative, input);
-			Output output = machineToMinimize.GetTransitionOutput(representative, input);
-			const State& newToState = oldStateToNewState.at(oldToState);
-
-			if (!minimizedMachine.HasTransition(newFromState, input))
+			const auto oldToState = table.GetNextState(representative, input);
+			if (oldToState != NO_ID)
 			{
-				minimizedMachine.AddTransition(newFromState, input, newToState, output);
+				minimizedMachine->AddTransition(newFromState, input, oldStateToNewState[oldToState], table.GetTransitionOutput(representative, input));
 			}
 		}
 	}
+	minimizedMachine->m_states.Generate(partitions.size(), "S");
+	minimizedMachine->InheritByteClasses(machineToMinimize);
 
-	minimizedMachine.m_inputs = machineToMinimize.m_inputs;
-	std::set<Output> uniqueOutputs;
-	for (const auto& map : minimizedMachine.m_transitions | std::views::values)
+	return minimizedMachine;
+}
+
+TransitionTable MealyMachine::Compile() const
+{
+	auto table = CompileTransitions();
+	for (StateId state = 0; state < m_edges.size(); ++state)
 	{
-		for (const auto& transList : map | std::views::values)
+		for (const auto& edge : m_edges[state])
 		{
-			uniqueOutputs.insert(transList.front().output);
+			table.SetTransitionOutput(state, edge.input, edge.output);
 		}
 	}
-	minimizedMachine.m_outputs.assign(uniqueOutputs.begin(), uniqueOutputs.end());
-	return std::make_unique<MealyMachine>(minimizedMachine);
+	return table;
 }
 
 std::string MealyMachine::GetTransitionOutput(const std::string& fromState, const std::string& input) const
@@ -411,16 +319,31 @@ std::string MealyMachine::GetTransitionOutput(const std::string& fromState, cons
 
 MealyMachine::Transition MealyMachine::GetTransition(const State& fromState, const Input& input) const
 {
-	auto transitions = GetTransitions(fromState, input);
-	if (transitions.empty())
+	const auto from = FindState(fromState);
+	const auto inputId = FindInput(input);
+
+	const Edge* transition = nullptr;
+	if (from != NO_ID)
 	{
-		throw std::runtime_error("No transition for state: " + fromState + ", input: " + input);
+		for (const auto& edge : m_edges[from])
+		{
+			if (edge.input != inputId)
+			{
+				continue;
+			}
+			if (transition)
+			{
+				throw std::runtime_error("Ambiguous transition (non-deterministic) for state: " + fromState + ", input: " + input);
+			}
+			transition = &edge;
+		}
 	}
-	if (transitions.size() > 1)
+
+	if (!transition)
 	{
-		throw std::runtime_error("Ambiguous transition (non-deterministic) for state: " + fromState + ", input: " + input);
+		throw std::runtime_error("No transition for state: " + fromState + ", input: " + input);
 	}
-	return transitions.front();
+	return { m_states.GetName(transition->to), m_outputs.GetName(transition->output) };
 }
 
 Machine::State MealyMachine::GetNextState(const State& fromState, const Input& input) const
@@ -430,262 +353,160 @@ Machine::State MealyMachine::GetNextState(const State& fromState, const Input& i
 
 void MealyMachine::Clear()
 {
-	m_states.clear();
-	m_inputs.clear();
-	m_outputs.clear();
-	m_transitions.clear();
+	ClearMachine();
+	m_initialState = NO_ID;
+	m_currentState = NO_ID;
 }
 
 void MealyMachine::RemoveUnreachableStates()
 {
-	if (m_initialState.empty() || m_states.empty())
+	if (m_initialState == NO_ID || m_states.Empty())
 	{
 		Clear();
 		return;
 	}
 
-	std::set<State> reachableStates;
-	std::queue<State> queue;
-
-	queue.push(m_initialState);
-	reachableStates.insert(m_initialState);
-
-	while (!queue.empty())
-	{
-		State current = queue.front();
-		queue.pop();
-
-		if (!m_transitions.contains(current))
-		{
-			continue;
-		}
-
-		for (const auto& transitionList : m_transitions.at(current) | std::views::values)
-		{
-			for (const auto& trans : transitionList)
-			{
-				if (reachableStates.contains(trans.nextState))
-				{
-					continue;
-				}
-				reachableStates.insert(trans.nextState);
-				queue.push(trans.nextState);
-			}
-		}
-	}
-
-	std::vector<State> newStates;
-	for (const auto& state : m_states)
-	{
-		if (reachableStates.contains(state))
-		{
-			newStates.push_back(state);
-		}
-	}
-	m_states = newStates;
-
-	std::unordered_map<State, std::unordered_map<Input, std::vector<Transition>>> newTransitions;
-	for (const auto& [from, transitions] : m_transitions)
-	{
-		if (!reachableStates.contains(from))
-		{
-			continue;
-		}
-		newTransitions[from] = transitions;
-	}
-
-	for (auto& transitions : newTransitions | std::views::values)
-	{
-		for (auto& transitionList : transitions | std::views::values)
-		{
-			std::vector<Transition> newTransitionList;
-			for (const auto& trans : transitionList)
-			{
-				if (!reachableStates.contains(trans.nextState))
-				{
-					continue;
-				}
-				newTransitionList.push_back(trans);
-			}
-			transitionList = newTransitionList;
-		}
-	}
-
-	m_transitions = newTransitions;
+	CompactStates(GetReachableStates());
 }
 
 bool MealyMachine::IsDeterministic() const
 {
-	for (const auto& transitions : m_transitions | std::views::values)
+	std::vector<StateId> lastSeenIn(m_inputs.Size(), NO_ID);
+	for (StateId state = 0; state < m_edges.size(); ++state)
 	{
-		if (transitions.contains(EPSILON))
+		for (const auto& edge : m_edges[state])
 		{
-			return false;
-		}
-
-		for (const auto& transitionList : transitions | std::views::values)
-		{
-			if (transitionList.size() > 1)
+			if (edge.input == EPSILON_ID || lastSeenIn[edge.input] == state)
 			{
 				return false;
 			}
+			lastSeenIn[edge.input] = state;
 		}
 	}
 	return true;
 }
 
-std::string StateSetToString(const std::set<MealyMachine::State>& stateSet)
-{
-	std::stringstream ss;
-	bool first = true;
-	for (const auto& state : stateSet)
-	{
-		if (!first)
-		{
-			ss << "_";
-		}
-		ss << state;
-		first = false;
-	}
-	return ss.str();
-}
-
 std::unique_ptr<Machine> MealyMachine::GetDeterministic() const
 {
 	if (IsDeterministic())
 	{
 		return std::make_unique<MealyMachine>(*this);
 	}
-
-	auto deterministicMachine = std::make_unique<MealyMachine>();
-	std::map<std::set<State>, State> knownStates;
-	std::queue<std::set<State>> workQueue;
-	int newStateCounter = 0;
-
-	std::set<State> initialClosure = EpsilonClosure({ m_initialState });
-	State newInitialStateName = "S" + std::to_string(newStateCounter++);
-
-	deterministicMachine->m_initialState = newInitialStateName;
-	deterministicMachine->m_currentState = newInitialStateName;
-	deterministicMachine->m_states.push_back(newInitialStateName);
-
-	knownStates[initialClosure] = newInitialStateName;
-	workQueue.push(initialClosure);
-
-	while (!workQueue.empty())
+	if (m_initialState == NO_ID)
 	{
-		std::set<State> currentSet = workQueue.front();
-		workQueue.pop();
-		State currentNewStateName = knownStates.at(currentSet);
+		throw std::runtime_error("Cannot determinize a machine without an initial state.");
+	}
 
-		for (const Input& input : m_inputs)
+	auto deterministicMachine = std::make_unique<MealyMachine>();
+	deterministicMachine->m_inputs = m_inputs;
+	deterministicMachine->m_outputs = m_outputs;
+
+	const auto closures = BuildEpsilonClosureIndex();
+	const auto epsilonConflicts = FindEpsilonOutputConflicts();
+	StateSetTable knownStates;
+	StateMarker marker(m_states.Size());
+
+	std::vector<StateId> initialClosure = { m_initialState };
+	closures.Close(initialClosure, marker);
+	AssertNoEpsilonOutputConflict(initialClosure, epsilonConflicts);
+	deterministicMachine->m_initialState = deterministicMachine->AddGeneratedState();
+	deterministicMachine->m_currentState = deterministicMachine->m_initialState;
+	knownStates.Intern(initialClosure);
+
+	// Deterministic state ids are the ids of their subsets in knownStates.
+	std::vector<std::vector<StateId>> nextStatesByInput(m_inputs.Size());
+	std::vector<OutputId> outputsByInput(m_inputs.Size());
+	for (StateId currentNewState = 0; currentNewState < knownStates.Size(); ++currentNewState)
+	{
+		std::ranges::fill(outputsByInput, NO_ID);
+		for (auto& nextStateSet : nextStatesByInput)
 		{
-			std::set<State> nextStateSet;
-			std::optional<Output> transitionOutput;
+			nextStateSet.clear();
+		}
 
-			for (const State& s : currentSet)
+		for (const auto s : knownStates.GetSet(currentNewState))
+		{
+			for (const auto& edge : m_edges[s])
 			{
-				auto transitions = GetTransitions(s, input);
-				for (const auto& trans : transitions)
+				if (edge.input == EPSILON_ID)
+				{
+					continue;
+				}
+				auto& transitionOutput = outputsByInput[edge.input];
+				if (transitionOutput == NO_ID)
+				{
+					transitionOutput = edge.output;
+				}
+				else if (transitionOutput != edge.output)
 				{
-					if (!transitionOutput.has_value())
-					{
-						transitionOutput = trans.output;
-					}
-					else if (transitionOutput.value() != trans.output)
-					{
-						throw std::runtime_error("Non-determinizable: Output mismatch for input '" + input + "' from states in set " + currentNewStateName);
-					}
-					nextStateSet.insert(trans.nextState);
+					throw std::runtime_error("Non-determinizable: Output mismatch for input '" + m_inputs.GetName(edge.input) + "' from states in set S" + std::to_string(currentNewState));
 				}
+				nextStatesByInput[edge.input].push_back(edge.to);
 			}
+		}
 
-			if (!transitionOutput.has_value())
+		for (InputId input = 0; input < m_inputs.Size(); ++input)
+		{
+			if (outputsByInput[input] == NO_ID)
 			{
 				continue;
 			}
 
-			std::set<State> nextStateClosure = EpsilonClosure(nextStateSet);
-			if (nextStateClosure.empty())
-			{
-				continue;
-			}
+			auto& nextStateClosure = nextStatesByInput[input];
+			closures.Close(nextStateClosure, marker);
 
-			State nextNewStateName;
-			if (!knownStates.contains(nextStateClosure))
+			const auto [nextNewState, isNew] = knownStates.Intern(nextStateClosure);
+			if (isNew)
 			{
-				nextNewStateName = "S" + std::to_string(newStateCounter++);
-				knownStates[nextStateClosure] = nextNewStateName;
-				workQueue.push(nextStateClosure);
-				deterministicMachine->m_states.push_back(nextNewStateName);
-			}
-			else
-			{
-				nextNewStateName = knownStates.at(nextStateClosure);
+				AssertNoEpsilonOutputConflict(nextStateClosure, epsilonConflicts);
+				deterministicMachine->AddGeneratedState();
 			}
 
 			deterministicMachine->AddTransition(
-				currentNewStateName,
+				currentNewState,
 				input,
-				nextNewStateName,
-				transitionOutput.value());
+				nextNewState,
+				outputsByInput[input]);
 		}
 	}
-	deterministicMachine->m_inputs = m_inputs;
+	deterministicMachine->m_states.Generate(knownStates.Size(), "S");
+	deterministicMachine->InheritByteClasses(*this);
 
-	std::set<Output> uniqueOutputs;
-	for (const auto& map : deterministicMachine->m_transitions | std::views::values)
-	{
-		for (const auto& transList : map | std::views::values)
-		{
-			for (const auto& trans : transList)
-			{
-				uniqueOutputs.insert(trans.output);
-			}
-		}
-	}
-	deterministicMachine->m_outputs.assign(uniqueOutputs.begin(), uniqueOutputs.end());
 	return deterministicMachine;
 }
 
-std::set<MealyMachine::State> MealyMachine::EpsilonClosure(const std::set<State>& states) const
+std::vector<bool> MealyMachine::FindEpsilonOutputConflicts() const
 {
-	std::set<State> closure = states;
-	std::queue<State> queue;
-	for (const auto& s : states)
-	{
-		queue.push(s);
-	}
-
-	while (!queue.empty())
+	std::vector<bool> conflicts(m_edges.size(), false);
+	for (StateId state = 0; state < m_edges.size(); ++state)
 	{
-		State state = queue.front();
-		queue.pop();
-
-		auto transitions = GetTransitions(state, EPSILON);
-		if (transitions.empty())
+		OutputId epsilonOutput = NO_ID;
+		for (const auto& edge : m_edges[state])
 		{
-			continue;
-		}
-
-		std::optional<Output> epsilonOutput;
-		for (const auto& trans : transitions)
-		{
-			if (!epsilonOutput.has_value())
+			if (edge.input != EPSILON_ID)
 			{
-				epsilonOutput = trans.output;
+				continue;
 			}
-			else if (epsilonOutput.value() != trans.output)
+			if (epsilonOutput == NO_ID)
 			{
-				throw std::runtime_error("Non-determinizable: Output mismatch for epsilon transitions from state " + state);
+				epsilonOutput = edge.output;
 			}
-
-			if (!closure.contains(trans.nextState))
+			else if (epsilonOutput != edge.output)
 			{
-				closure.insert(trans.nextState);
-				queue.push(trans.nextState);
+				conflicts[state] = true;
 			}
 		}
 	}
-	return closure;
+	return conflicts;
+}
+
+void MealyMachine::AssertNoEpsilonOutputConflict(const std::vector<StateId>& states, const std::vector<bool>& conflicts) const
+{
+	for (const auto state : states)
+	{
+		if (conflicts[state])
+		{
+			throw std::runtime_error("Non-determinizable: Output mismatch for epsilon transitions from state " + m_states.GetName(state));
+		}
+	}
 }
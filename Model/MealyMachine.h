@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Machine.h"
+#include "StateSetTable.h"
 
 #include <set>
 #include <unordered_map>
@@ -25,13 +26,16 @@ public:
 
 	static const Input EPSILON;
 
-	explicit MealyMachine(State initialState = "");
+	explicit MealyMachine(const State& initialState = "");
 	explicit MealyMachine(MooreMachine& mooreMachine);
 
 	void FromDot(const std::string& fileName) override;
-	void SaveToDot(const std::string& fileName) override;
+	void SaveToDot(const std::string& fileName, const DotOptions& options = {}) override;
+	void FromBinary(const std::string& fileName) override;
+	void SaveToBinary(const std::string& fileName) override;
 	bool HasTransition(const State& from, const Input& input) const override;
-	std::unique_ptr<Machine> GetMinimized() const override;
+	std::unique_ptr<Machine> GetMinimized(const MinimizeOptions& options = {}) const override;
+	TransitionTable Compile() const override;
 	State GetNextState(const State& fromState, const Input& input) const override;
 
 	void AddTransition(
@@ -50,19 +54,19 @@ public:
 
 	State GetInitialState() const override
 	{
-		return m_initialState;
+		return GetStateName(m_initialState);
 	}
 
 private:
-	using TransitionMap = std::unordered_map<State, std::unordered_map<Input, std::vector<Transition>>>;
-
 	void ConvertFromMoore(MooreMachine& moore);
 	void RemoveUnreachableStates();
 	void Clear();
 
-	std::set<State> EpsilonClosure(const std::set<State>& states) const;
+	void AddTransition(StateId from, InputId input, StateId to, OutputId output);
+	// Adds an unnamed state, names are generated once the whole machine is built.
+	StateId AddGeneratedState();
 
-	State m_initialState;
-	State m_currentState;
-	TransitionMap m_transitions;
+	// States whose epsilon transitions disagree on the output, such states cannot be determinized.
+	std::vector<bool> FindEpsilonOutputConflicts() const;
+	void AssertNoEpsilonOutputConflict(const std::vector<StateId>& states, const std::vector<bool>& conflicts) const;
 };
@@ -1,188 +1,261 @@
 #include "MooreMachine.h"
+#include "MappedFile.h"
 #include "MealyMachine.h"
+#include "RegularExpression.h"
+#include "RegularTree.h"
 #include <algorithm>
+#include <cctype>
 #include <fstream>
+#include <iterator>
 #include <iostream>
+#include <map>
 #include <queue>
 #include <ranges>
-#include <regex>
 #include <set>
 
 const Machine::Input MooreMachine::EPSILON = "";
 const Machine::State MooreMachine::F_STATE = "F_STATE";
 const Machine::State MooreMachine::S_START = "S_START";
 
-bool IsCharSpecial(char c);
-void ValidateRegex(const std::string& expr);
-
-MooreMachine::MooreMachine(State initialState)
-	: m_initialState(initialState)
-	, m_currentState(std::move(initialState))
+namespace
+{
+// Patterns are sorted and unique.
+std::string GetPatternSetName(const std::vector<size_t>& patterns)
 {
+	std::string name = "{";
+	for (const auto pattern : patterns)
+	{
+		name += (name.size() > 1 ? "," : "") + std::to_string(pattern);
+	}
+	return name + "}";
 }
 
-MooreMachine::MooreMachine(MealyMachine& mealyMachine)
+// A repetition of one class that GLUSHKOV would unroll, that is one other than "*", "+" and "?".
+bool IsCountedRepetition(const RegularTree& tree, const RegularTree::Id repetition)
 {
-	ConvertFromMealy(mealyMachine);
+	const auto& node = tree.GetNode(repetition);
+	return node.kind == RegularTree::Kind::REPETITION && tree.GetNode(node.children.front()).kind == RegularTree::Kind::CLASS
+		&& !(node.max == RegularTree::UNBOUNDED && node.min <= 1) && !(node.min == 0 && node.max == 1);
 }
 
-void MooreMachine::AddStateOutput(const State& state, const Output& output)
+// Positions GLUSHKOV builds for the tree, the start not included, with every repetition unrolled
+// or with counted repetitions as one position each. Saturates at SIZE_MAX.
+size_t CountGlushkovPositions(const RegularTree& tree, const RegularTree::Id root, const bool isCounting)
 {
-	m_stateOutputs[state] = output;
-
-	if (std::ranges::find(m_states, state) == m_states.end())
+	const auto& node = tree.GetNode(root);
+	switch (node.kind)
+	{
+	case RegularTree::Kind::CLASS:
+		return 1;
+	case RegularTree::Kind::CONCATENATION:
+	case RegularTree::Kind::ALTERNATION:
 	{
-		m_states.push_back(state);
+		size_t count = 0;
+		for (const auto child : node.children)
+		{
+			const auto childCount = CountGlushkovPositions(tree, child, isCounting);
+			count = count > SIZE_MAX - childCount ? SIZE_MAX : count + childCount;
+		}
+		return count;
 	}
-	if (std::ranges::find(m_outputs, output) == m_outputs.end())
+	case RegularTree::Kind::REPETITION:
 	{
-		m_outputs.push_back(output);
+		const auto childCount = CountGlushkovPositions(tree, node.children.front(), isCounting);
+		if (isCounting && IsCountedRepetition(tree, root))
+		{
+			return childCount;
+		}
+		// CreateRepetitionNFA makes max copies, or min and at least one without a maximum.
+		const auto copies = node.max == RegularTree::UNBOUNDED ? std::max<size_t>(node.min, 1) : node.max;
+		return childCount != 0 && copies > SIZE_MAX / childCount ? SIZE_MAX : childCount * copies;
+	}
+	case RegularTree::Kind::EPSILON:
+		break;
 	}
+	return 0;
+}
+
+void SkipGrammarSpaces(std::string_view& text)
+{
+	const auto first = text.find_first_not_of(" \t\r");
+	text.remove_prefix(first == std::string_view::npos ? text.size() : first);
 }
 
-void MooreMachine::AddTransition(const State& from, const Input& input, const State& to)
+// Same as \w+ after optional spaces, the word is removed from the text.
+std::string_view ReadGrammarWord(std::string_view& text)
 {
-	auto& nextStates = m_transitions[from][input];
-	if (std::ranges::find(nextStates, to) == nextStates.end())
+	SkipGrammarSpaces(text);
+	size_t length = 0;
+	while (length < text.size() && (std::isalnum(static_cast<unsigned char>(text[length])) || text[length] == '_'))
 	{
-		nextStates.push_back(to);
+		++length;
 	}
+	const auto word = text.substr(0, length);
+	text.remove_prefix(length);
+	return word;
+}
+} // namespace
 
-	if (std::ranges::find(m_states, from) == m_states.end())
+MooreMachine::MooreMachine(const State& initialState)
+{
+	if (!initialState.empty())
 	{
-		m_states.push_back(from);
+		m_initialState = AddState(initialState);
+		m_currentState = m_initialState;
 	}
-	if (std::ranges::find(m_states, to) == m_states.end())
+}
+
+MooreMachine::MooreMachine(MealyMachine& mealyMachine)
+{
+	ConvertFromMealy(mealyMachine);
+}
+
+void MooreMachine::AddStateOutput(const std::string_view state, const std::string_view output)
+{
+	const auto stateId = AddState(state);
+	SetStateOutput(stateId, m_outputs.Intern(output));
+}
+
+void MooreMachine::AddTransition(const std::string_view from, const std::string_view input, const std::string_view to)
+{
+	const auto fromId = AddState(from);
+	const auto toId = AddState(to);
+	AddTransition(fromId, AddInput(input), toId);
+}
+
+void MooreMachine::AddTransition(const StateId from, const InputId input, const StateId to)
+{
+	auto& edges = m_edges[from];
+	const auto isKnown = std::ranges::any_of(edges, [&](const Edge& edge) {
+		return edge.input == input && edge.to == to;
+	});
+	if (!isKnown)
 	{
-		m_states.push_back(to);
+		edges.push_back({ input, to, NO_ID });
 	}
-	if (input != EPSILON && std::ranges::find(m_inputs, input) == m_inputs.end())
+}
+
+void MooreMachine::SetStateOutput(const StateId state, const OutputId output)
+{
+	if (state >= m_stateOutputs.size())
 	{
-		m_inputs.push_back(input);
+		m_stateOutputs.resize(state + 1, NO_ID);
 	}
+	m_stateOutputs[state] = output;
 }
 
-void MooreMachine::FromDot(const std::string& fileName)
+Machine::OutputId MooreMachine::GetStateOutputId(const StateId state) const
+{
+	return state < m_stateOutputs.size() ? m_stateOutputs[state] : NO_ID;
+}
+
+Machine::OutputId MooreMachine::GetOutputIdForState(const StateId state) const
 {
-	std::ifstream file(fileName);
-	AssertInputIsOpen(file, fileName);
+	const auto output = GetStateOutputId(state);
+	if (output == NO_ID)
+	{
+		throw std::runtime_error("No output defined for state: " + GetStateName(state));
+	}
+	return output;
+}
 
-	const std::regex edgeRegex(R"((\w+)\s*->\s*(\w+)\s*\[label\s*=\s*\"([^"]*)\"\]\s*;)");
-	const std::regex outputRegex(R"((\w+)\s*\[label\s*=\s*\"(\w+)\s*\/\s*([^\"]+)\"*)");
-	const std::regex stateOutputRegex(R"((\w+)\s*\[output\s*=\s*\"([^\"]+)\"\]\s*;)");
-	const std::regex digraphRegex(R"(digraph\s+(\w+)\s*\{)");
-	const std::regex initialRegex(R"(\s*(\w+)\s*\[.*shape\s*=\s*doublecircle.*\]\s*;)");
+Machine::StateId MooreMachine::AddGeneratedState(const OutputId output)
+{
+	const auto state = static_cast<StateId>(m_edges.size());
+	m_edges.emplace_back();
+	m_stateOutputs.push_back(output);
+	return state;
+}
 
-	State initialState;
+void MooreMachine::FromDot(const std::string& fileName)
+{
 	Clear();
 
-	std::string line;
-	while (std::getline(file, line))
-	{
-		line.erase(0, line.find_first_not_of(" \t"));
-		line.erase(line.find_last_not_of(" \t") + 1);
-
-		if (line.empty() || line.substr(0, 2) == "//")
-		{
-			continue;
-		}
-		std::smatch match;
-		if (std::regex_search(line, match, digraphRegex))
+	const auto onNode = [&](const StateId state, const DotStatement& statement) {
+		const auto output = ReadDotOutput(statement);
+		if (output)
 		{
-			continue;
+			SetStateOutput(state, m_outputs.Intern(*output));
 		}
-		if (std::regex_search(line, match, stateOutputRegex))
+		else if (statement.GetAttribute("shape") && GetStateOutputId(state) == NO_ID)
 		{
-			State state = match[1];
-			Output output = match[2];
-			AddStateOutput(state, output);
-			continue;
+			SetStateOutput(state, m_outputs.Intern("default"));
 		}
-		if (std::regex_search(line, match, outputRegex))
+	};
+
+	const auto onEdge = [&](const StateId from, const StateId to, const DotStatement& statement) {
+		const auto label = statement.GetAttribute("label");
+		if (!label)
 		{
-			State state = match[1];
-			Output output = match[3];
-			AddStateOutput(state, output);
-			continue;
+			throw DotParser::MakeError(fileName, statement.line, statement.column, "expected a label with the input");
 		}
-		if (std::regex_search(line, match, edgeRegex))
+		const auto addTransition = [&](const std::string_view input) {
+			AddTransition(from, input == "e" ? EPSILON_ID : AddInput(DotParser::Unescape(input)), to);
+		};
+		if (statement.GetAttribute("merged"))
 		{
-			State fromState = match[1];
-			State toState = match[2];
-			Input input = match[3];
-
-			if (!input.empty() && input.front() == '"' && input.back() == '"')
-			{
-				input = input.substr(1, input.length() - 2);
-			}
-			if (input == "e")
-			{
-				input = EPSILON;
-			}
-
-			AddTransition(fromState, input, toState);
+			DotParser::SplitList(*label, addTransition);
 		}
-		else if (std::regex_search(line, match, initialRegex))
+		else
 		{
-			initialState = match[1];
+			addTransition(*label);
 		}
-		else if (line.find("[shape=circle]") != std::string::npos || line.find("[shape=doublecircle]") != std::string::npos)
-		{
-			auto pos = line.find('[');
-			if (pos != std::string::npos)
-			{
-				State state = line.substr(0, pos);
-				state.erase(state.find_last_not_of(" \t") + 1);
+	};
 
-				if (!m_stateOutputs.contains(state))
-				{
-					AddStateOutput(state, "default");
-				}
-				if (line.find("doublecircle") != std::string::npos)
-				{
-					initialState = state;
-				}
-			}
-		}
+	LoadDot(fileName, onNode, onEdge);
+}
+
+std::optional<std::string_view> MooreMachine::ReadDotOutput(const DotStatement& statement)
+{
+	if (const auto output = statement.GetAttribute("output"))
+	{
+		return DotParser::Trim(*output);
 	}
-	file.close();
 
-	if (!initialState.empty())
+	const auto label = statement.GetAttribute("label");
+	if (!label)
+	{
+		return std::nullopt;
+	}
+	if (const auto lineBreak = label->find("\\n"); lineBreak != std::string_view::npos)
 	{
-		m_initialState = initialState;
-		m_currentState = initialState;
+		auto output = DotParser::Trim(label->substr(lineBreak + 2));
+		if (output.starts_with("output:"))
+		{
+			output = DotParser::Trim(output.substr(7));
+		}
+		return output;
 	}
-	else if (!m_states.empty())
+	if (const auto slash = label->find('/'); slash != std::string_view::npos)
 	{
-		m_initialState = m_states[0];
-		m_currentState = m_states[0];
+		return DotParser::Trim(label->substr(slash + 1));
 	}
+	return std::nullopt;
 }
 
-void MooreMachine::SaveToDot(const std::string& fileName)
+void MooreMachine::SaveToDot(const std::string& fileName, const DotOptions& options)
 {
-	std::ofstream file(fileName);
-	AssertOutputIsOpen(file, fileName);
+	DotWriter file(fileName);
 
-	file << "digraph MooreMachine {" << std::endl;
-	file << "    rankdir=LR;" << std::endl;
-	file << "    size=\"8,5\"" << std::endl
-		 << std::endl;
+	file << "digraph MooreMachine {\n";
+	file << "    rankdir=LR;\n";
+	file << "    size=\"8,5\"\n\n";
 
-	for (const auto& state : m_states)
+	for (StateId state = 0; state < m_states.Size(); ++state)
 	{
-		file << "    " << state << " [label=\"" << state << "\\n";
+		const auto& name = m_states.GetName(state);
+		file << "    " << name << " [label=\"" << name << "\\n";
 
-		auto outputIt = m_stateOutputs.find(state);
-		if (outputIt != m_stateOutputs.end())
+		const auto output = GetStateOutputId(state);
+		if (output != NO_ID)
 		{
-			file << outputIt->second;
+			file << m_outputs.GetName(output);
 		}
 		else
 		{
 			file << "none";
 		}
-		file << "\"";
+		file << '"';
 
 		if (state == m_initialState)
 		{
@@ -193,29 +266,42 @@ void MooreMachine::SaveToDot(const std::string& fileName)
 			file << ", shape=circle";
 		}
 
-		file << "];" << std::endl;
+		file << "];\n";
 	}
-	file << std::endl;
+	file << '\n';
 
-	for (const auto& [fromState, transitions] : m_transitions)
-	{
-		for (const auto& [input, nextStates] : transitions)
+	WriteDotEdges(file, options, [&](DotWriter& writer, const Edge& edge) {
+		if (edge.input == EPSILON_ID)
 		{
-			for (const auto& nextState : nextStates)
-			{
-				std::string label = (input == EPSILON) ? "e" : input;
-				file << "    " << fromState << " -> "
-					 << nextState
-					 << " [label=\"" << label
-					 << "\"];" << std::endl;
-			}
+			writer << "e";
 		}
-	}
+		else
+		{
+			writer.WriteEscaped(m_inputs.GetName(edge.input));
+		}
+	});
+
+	file << "}\n";
+	file.Close();
+}
+
+void MooreMachine::FromBinary(const std::string& fileName)
+{
+	Clear();
+	m_stateOutputs = ReadBinary(fileName, BinaryFormat::MachineKind::MOORE);
+}
 
-	file << "}" << std::endl;
+void MooreMachine::SaveToBinary(const std::string& fileName)
+{
+	std::vector<OutputId> stateOutputs(m_states.Size());
+	for (StateId state = 0; state < stateOutputs.size(); ++state)
+	{
+		stateOutputs[state] = GetStateOutputId(state);
+	}
+	WriteBinary(fileName, BinaryFormat::MachineKind::MOORE, stateOutputs);
 }
 
-std::unique_ptr<Machine> MooreMachine::GetMinimized() const
+std::unique_ptr<Machine> MooreMachine::GetMinimized(const MinimizeOptions& options) const
 {
 	if (!IsDeterministic())
 	{
@@ -226,72 +312,77 @@ std::unique_ptr<Machine> MooreMachine::GetMinimized() const
 	MooreMachine machineToMinimize = *this;
 	machineToMinimize.RemoveUnreachableStates();
 
-	if (machineToMinimize.m_states.empty())
+	if (machineToMinimize.m_states.Empty())
 	{
 		return std::make_unique<MooreMachine>();
 	}
 
-	std::map<Output, std::vector<State>> initialGroups;
-	for (const auto& state : machineToMinimize.m_states)
+	const auto table = machineToMinimize.Compile();
+	const auto outputRanks = machineToMinimize.GetOutputRanks();
+	std::map<OutputId, std::vector<StateId>> initialGroups;
+	for (StateId state = 0; state < table.GetStateCount(); ++state)
 	{
-		initialGroups[machineToMinimize.GetOutputForState(state)].push_back(state);
+		initialGroups[outputRanks[machineToMinimize.GetOutputIdForState(state)]].push_back(state);
 	}
 
-	std::vector<std::vector<State>> partitions;
-	for (const auto& val : initialGroups | std::views::values)
+	Partitions partitions;
+	for (auto& val : initialGroups | std::views::values)
 	{
-		partitions.push_back(val);
+		partitions.push_back(std::move(val));
 	}
 
-	partitions = machineToMinimize.BreakForPartitions(partitions);
-	MooreMachine minimizedMachine;
-	std::unordered_map<State, State> oldStateToNewState;
-	int newStateCounter = 0;
+	partitions = machineToMinimize.RefinePartitions(table, partitions, options);
+
+	auto minimizedMachine = std::make_unique<MooreMachine>();
+	minimizedMachine->m_inputs = machineToMinimize.m_inputs;
+	minimizedMachine->m_outputs = machineToMinimize.m_outputs;
 
+	std::vector<StateId> oldStateToNewState(machineToMinimize.m_states.Size(), NO_ID);
 	for (const auto& group : partitions)
 	{
-		State newStateName = "S" + std::to_string(newStateCounter++);
-		minimizedMachine.m_states.push_back(newStateName);
-
-		State representative = group.front();
-		minimizedMachine.AddStateOutput(newStateName, machineToMinimize.GetOutputForState(representative));
+		StateId representative = group.front();
+		const auto newState = minimizedMachine->AddGeneratedState(table.GetStateOutput(representative));
 
-		for (const auto& oldState : group)
+		for (const auto oldState : group)
 		{
-			oldStateToNewState[oldState] = newStateName;
+			oldStateToNewState[oldState] = newState;
 		}
 
 		if (std::ranges::find(group, machineToMinimize.m_initialState) != group.end())
 		{
-			minimizedMachine.m_initialState = newStateName;
-			minimizedMachine.m_currentState = newStateName;
+			minimizedMachine->m_initialState = newState;
+			minimizedMachine->m_currentState = newState;
 		}
 	}
 
 	for (const auto& group : partitions)
 	{
-		State representative = group.front();
-		const State& newFromState = oldStateToNewState.at(representative);
+		StateId representative = group.front();
+		const auto newFromState = oldStateToNewState[representative];
 
-		for (const auto& input : machineToMinimize.m_inputs)
+		for (InputId input = 0; input < table.GetInputCount(); ++input)
 		{
-			if (!machineToMinimize.HasTransition(representative, input))
+			const auto oldToState = table.GetNextState(representative, input);
+			if (oldToState != NO_ID)
 			{
-				continue;
-			}
-			State oldToState = machineToMinimize.GetNextState(representative, input);
-			const State& newToState = oldStateToNewState.at(oldToState);
-
-			if (!minimizedMachine.HasTransition(newFromState, input))
-			{
-				minimizedMachine.AddTransition(newFromState, input, newToState);
+				minimizedMachine->AddTransition(newFromState, input, oldStateToNewState[oldToState]);
 			}
 		}
 	}
-	minimizedMachine.m_inputs = machineToMinimize.m_inputs;
-	minimizedMachine.m_outputs = machineToMinimize.m_outputs;
+	minimizedMachine->m_states.Generate(partitions.size(), "S");
+	minimizedMachine->InheritByteClasses(machineToMinimize);
 
-	return std::make_unique<MooreMachine>(minimizedMachine);
+	return minimizedMachine;
+}
+
+TransitionTable MooreMachine::Compile() const
+{
+	auto table = CompileTransitions();
+	for (StateId state = 0; state < table.GetStateCount(); ++state)
+	{
+		table.SetStateOutput(state, GetStateOutputId(state));
+	}
+	return table;
 }
 
 void MooreMachine::ConvertFromMealy(MealyMachine& mealy)
@@ -308,11 +399,11 @@ void MooreMachine::ConvertFromMealy(MealyMachine& mealy)
 	std::queue<std::pair<State, Output>> statesToProcess;
 
 	const Output initialOutput = "eps";
-	m_initialState = mealyInitialState;
-	m_currentState = mealyInitialState;
+	AddStateOutput(mealyInitialState, initialOutput);
+	m_initialState = FindState(mealyInitialState);
+	m_currentState = m_initialState;
 
-	AddStateOutput(m_currentState, initialOutput);
-	newStatesMap[{ mealyInitialState, initialOutput }] = m_currentState;
+	newStatesMap[{ mealyInitialState, initialOutput }] = mealyInitialState;
 	statesToProcess.emplace(mealyInitialState, initialOutput);
 
 	const auto& mealyInputs = mealy.GetInputs();
@@ -357,76 +448,80 @@ void MooreMachine::ConvertFromMealy(MealyMachine& mealy)
 
 bool MooreMachine::HasTransition(const State& from, const Input& input) const
 {
-	const auto stateIt = m_transitions.find(from);
-	if (stateIt == m_transitions.end())
-	{
-		return false;
-	}
-	const auto inputIt = stateIt->second.find(input);
-	if (inputIt == stateIt->second.end())
-	{
-		return false;
-	}
-	return !inputIt->second.empty();
+	return HasEdge(FindState(from), FindInput(input));
 }
 
 std::vector<Machine::State> MooreMachine::GetNextStates(const State& fromState, const Input& input) const
 {
-	const auto stateIt = m_transitions.find(fromState);
-	if (stateIt == m_transitions.end())
+	const auto from = FindState(fromState);
+	const auto inputId = FindInput(input);
+	if (from == NO_ID || inputId == NO_ID)
 	{
 		return {};
 	}
 
-	const auto inputIt = stateIt->second.find(input);
-	if (inputIt == stateIt->second.end())
+	std::vector<State> nextStates;
+	for (const auto& edge : m_edges[from])
 	{
-		return {};
+		if (edge.input == inputId)
+		{
+			nextStates.push_back(m_states.GetName(edge.to));
+		}
 	}
-
-	return inputIt->second;
+	return nextStates;
 }
 
 Machine::State MooreMachine::GetNextState(const State& fromState, const Input& input) const
 {
-	auto nextStates = GetNextStates(fromState, input);
+	const auto from = FindState(fromState);
+	const auto inputId = FindInput(input);
 
-	if (nextStates.empty())
+	StateId nextState = NO_ID;
+	if (from != NO_ID)
 	{
-		throw std::runtime_error("No transition from state: " + fromState + " with input: " + input);
+		for (const auto& edge : m_edges[from])
+		{
+			if (edge.input != inputId)
+			{
+				continue;
+			}
+			if (nextState != NO_ID)
+			{
+				throw std::runtime_error("Ambiguous transition (non-deterministic) for state: " + fromState + ", input: " + input);
+			}
+			nextState = edge.to;
+		}
 	}
-	if (nextStates.size() > 1)
+
+	if (nextState == NO_ID)
 	{
-		throw std::runtime_error("Ambiguous transition (non-deterministic) for state: " + fromState + ", input: " + input);
+		throw std::runtime_error("No transition from state: " + fromState + " with input: " + input);
 	}
-	return nextStates.front();
+	return m_states.GetName(nextState);
 }
 
 Machine::Output MooreMachine::GetOutputForState(const State& state) const
 {
-	const auto it = m_stateOutputs.find(state);
-	if (it == m_stateOutputs.end())
+	const auto output = GetStateOutputId(FindState(state));
+	if (output == NO_ID)
 	{
 		throw std::runtime_error("No output defined for state: " + state);
 	}
-	return it->second;
+	return m_outputs.GetName(output);
 }
 
 bool MooreMachine::IsDeterministic() const
 {
-	for (const auto& transitions : m_transitions | std::views::values)
+	std::vector<StateId> lastSeenIn(m_inputs.Size(), NO_ID);
+	for (StateId state = 0; state < m_edges.size(); ++state)
 	{
-		if (transitions.contains(EPSILON) && !transitions.at(EPSILON).empty())
-		{
-			return false;
-		}
-
-		for (const auto& nextStates : transitions | std::views::values)
+		for (const auto& edge : m_edges[state])
 		{
-			if (nextStates.size() > 1)
+			if (edge.input == EPSILON_ID || lastSeenIn[edge.input] == state)
 			{
 				return false;
 			}
+			lastSeenIn[edge.input] = state;
 		}
 	}
 	return true;
@@ -434,11 +529,10 @@ bool MooreMachine::IsDeterministic() const
 
 void MooreMachine::Clear()
 {
-	m_states.clear();
-	m_inputs.clear();
-	m_outputs.clear();
+	ClearMachine();
 	m_stateOutputs.clear();
-	m_transitions.clear();
+	m_initialState = NO_ID;
+	m_currentState = NO_ID;
 	m_stateCounter = 0;
 }
 
@@ -448,242 +542,285 @@ std::unique_ptr<Machine> MooreMachine::GetDeterministic() const
 	{
 		return std::make_unique<MooreMachine>(*this);
 	}
+	if (m_initialState == NO_ID)
+	{
+		throw std::runtime_error("Cannot determinize a machine without an initial state.");
+	}
 
 	auto dfa = std::make_unique<MooreMachine>();
-	std::map<std::set<State>, State> knownStates;
-	std::queue<std::set<State>> workQueue;
-	int newStateCounter = 0;
+	dfa->m_inputs = m_inputs;
+	dfa->m_outputs = m_outputs;
+
+	const auto closures = BuildEpsilonClosureIndex();
+	StateSetTable knownStates;
+	StateMarker marker(m_states.Size());
 
-	std::set<State> initialSet = EpsilonClosure({ m_initialState });
-	auto initialOutputOpt = GetConsistentOutput(initialSet);
+	std::vector<StateId> initialSet = { m_initialState };
+	closures.Close(initialSet, marker);
+	auto initialOutputOpt = GetConsistentOutput(initialSet, dfa->m_outputs);
 	if (!initialOutputOpt.has_value())
 	{
 		throw std::runtime_error("Non-determinizable: Output conflict in initial state's epsilon closure.");
 	}
-	const Output& initialOutput = initialOutputOpt.value();
-
-	State newInitialStateName = "S" + std::to_string(newStateCounter++);
-	dfa->AddStateOutput(newInitialStateName, initialOutput);
-	dfa->m_initialState = newInitialStateName;
-	dfa->m_currentState = newInitialStateName;
 
-	knownStates[initialSet] = newInitialStateName;
-	workQueue.push(initialSet);
+	dfa->m_initialState = dfa->AddGeneratedState(initialOutputOpt.value());
+	dfa->m_currentState = dfa->m_initialState;
+	knownStates.Intern(initialSet);
 
-	while (!workQueue.empty())
+	// DFA state ids are the ids of their subsets in knownStates.
+	std::vector<std::vector<StateId>> nextStatesByInput(m_inputs.Size());
+	for (StateId dfaFromState = 0; dfaFromState < knownStates.Size(); ++dfaFromState)
 	{
-		std::set<State> currentSet = workQueue.front();
-		workQueue.pop();
-		State dfaFromState = knownStates.at(currentSet);
-
-		for (const Input& input : m_inputs)
+		for (auto& nextStateSet : nextStatesByInput)
 		{
-			std::set<State> nextStateSet;
-
-			for (const State& s : currentSet)
+			nextStateSet.clear();
+		}
+		for (const auto s : knownStates.GetSet(dfaFromState))
+		{
+			for (const auto& edge : m_edges[s])
 			{
-				auto nextStates = GetNextStates(s, input);
-				nextStateSet.insert(nextStates.begin(), nextStates.end());
+				if (edge.input != EPSILON_ID)
+				{
+					nextStatesByInput[edge.input].push_back(edge.to);
+				}
 			}
+		}
 
+		for (InputId input = 0; input < m_inputs.Size(); ++input)
+		{
+			auto& nextStateSet = nextStatesByInput[input];
 			if (nextStateSet.empty())
 			{
 				continue;
 			}
 
-			std::set<State> nextStateClosure = EpsilonClosure(nextStateSet);
-			if (nextStateClosure.empty())
-			{
-				continue;
-			}
+			closures.Close(nextStateSet, marker);
 
-			State dfaToState;
-			if (!knownStates.contains(nextStateClosure))
+			const auto [dfaToState, isNew] = knownStates.Intern(nextStateSet);
+			if (isNew)
 			{
-				auto nextOutputOpt = GetConsistentOutput(nextStateClosure);
+				auto nextOutputOpt = GetConsistentOutput(nextStateSet, dfa->m_outputs);
 				if (!nextOutputOpt.has_value())
 				{
-					throw std::runtime_error("Non-determinizable: Output conflict in subset for input '" + input + "'");
+					throw std::runtime_error("Non-determinizable: Output conflict in subset for input '" + m_inputs.GetName(input) + "'");
 				}
-				const Output& nextOutput = nextOutputOpt.value();
-
-				dfaToState = "S" + std::to_string(newStateCounter++);
-				dfa->AddStateOutput(dfaToState, nextOutput);
-				knownStates[nextStateClosure] = dfaToState;
-				workQueue.push(nextStateClosure);
-			}
-			else
-			{
-				dfaToState = knownStates.at(nextStateClosure);
+				dfa->AddGeneratedState(nextOutputOpt.value());
 			}
 			dfa->AddTransition(dfaFromState, input, dfaToState);
 		}
 	}
-
-	dfa->m_inputs = m_inputs;
-
-	std::set<Output> uniqueOutputs;
-	for (const auto& output : dfa->m_stateOutputs | std::views::values)
-	{
-		uniqueOutputs.insert(output);
-	}
-	dfa->m_outputs.assign(uniqueOutputs.begin(), uniqueOutputs.end());
+	dfa->m_states.Generate(knownStates.Size(), "S");
+	dfa->InheritByteClasses(*this);
 
 	return dfa;
 }
 
-std::set<Machine::State> MooreMachine::EpsilonClosure(const std::set<State>& states) const
+LazyDfa MooreMachine::GetLazyDeterministic(const size_t cacheSize) const
 {
-	std::set<State> closure = states;
-	std::queue<State> queue;
-	for (const auto& s : states)
+	if (m_initialState == NO_ID)
 	{
-		queue.push(s);
+		throw std::runtime_error("Cannot determinize a machine without an initial state.");
 	}
 
-	while (!queue.empty())
+	std::vector<size_t> firstTransition(m_edges.size() + 1, 0);
+	std::vector<LazyDfa::Transition> transitions;
+	for (StateId state = 0; state < m_edges.size(); ++state)
 	{
-		State s = queue.front();
-		queue.pop();
-
-		auto nextStates = GetNextStates(s, EPSILON);
-		for (const auto& nextState : nextStates)
+		for (const auto& edge : m_edges[state])
 		{
-			if (closure.contains(nextState))
+			if (edge.input != EPSILON_ID)
 			{
-				continue;
+				transitions.push_back({ edge.input, edge.to });
 			}
-			closure.insert(nextState);
-			queue.push(nextState);
 		}
+		std::sort(transitions.begin() + static_cast<std::ptrdiff_t>(firstTransition[state]), transitions.end(),
+			[](const LazyDfa::Transition& left, const LazyDfa::Transition& right) {
+				return left.input < right.input;
+			});
+		firstTransition[state + 1] = transitions.size();
 	}
-	return closure;
+
+	// The lazy DFA may outlive this machine, so the outputs are read from a copy. Unions of
+	// pattern sets go to a table of its own that keeps the ids of the machine.
+	const auto machine = std::make_shared<const MooreMachine>(*this);
+	const auto outputs = std::make_shared<SymbolTable>(m_outputs);
+	return {
+		std::move(firstTransition),
+		std::move(transitions),
+		BuildEpsilonClosureIndex(),
+		m_initialState,
+		m_inputs.Size(),
+		[machine, outputs](const std::vector<StateId>& states) {
+			return machine->GetConsistentOutput(states, *outputs);
+		},
+		cacheSize,
+	};
 }
 
-std::optional<Machine::Output> MooreMachine::GetConsistentOutput(const std::set<State>& states) const
+BitParallelNfa MooreMachine::GetBitParallel() const
 {
-	if (states.empty())
+	if (m_initialState == NO_ID)
 	{
-		return std::nullopt;
+		throw std::runtime_error("Cannot simulate a machine without an initial state.");
 	}
-
-	std::optional<Output> finalOutput;
-
-	for (const auto& state : states)
+	const auto zeroOutput = m_outputs.Find("0");
+	const auto oneOutput = m_outputs.Find("1");
+	for (StateId state = 0; state < m_states.Size(); ++state)
 	{
-		Output currentOutput = GetOutputForState(state);
-
-		if (!finalOutput.has_value())
+		const auto output = GetOutputIdForState(state);
+		if (output != zeroOutput && output != oneOutput)
 		{
-			finalOutput = currentOutput;
+			throw std::runtime_error("Bit-parallel simulation needs the outputs 0 and 1 only.");
 		}
-		else if (finalOutput.value() != currentOutput)
+	}
+
+	// Position 0 is the initial state, every other one is a transition target with the input
+	// that enters it.
+	std::map<std::pair<InputId, StateId>, StateId> positionIds;
+	std::vector<std::pair<InputId, StateId>> positions = { { NO_ID, m_initialState } };
+	for (StateId state = 0; state < m_edges.size(); ++state)
+	{
+		for (const auto& edge : m_edges[state])
 		{
-			if ((finalOutput.value() == "0" && currentOutput == "1") || (finalOutput.value() == "1" && currentOutput == "0"))
+			const auto position = static_cast<StateId>(positions.size());
+			if (edge.input != EPSILON_ID && positionIds.emplace(std::make_pair(edge.input, edge.to), position).second)
 			{
-				finalOutput = "1";
+				positions.emplace_back(edge.input, edge.to);
 			}
-			else
+		}
+	}
+	if (positions.size() > BitParallelNfa::MAX_POSITIONS)
+	{
+		throw std::runtime_error("The machine has " + std::to_string(positions.size())
+			+ " positions, bit-parallel simulation supports " + std::to_string(BitParallelNfa::MAX_POSITIONS) + ".");
+	}
+
+	const auto closures = BuildEpsilonClosureIndex();
+	std::vector<InputId> positionInputs;
+	std::vector<size_t> firstFollow = { 0 };
+	std::vector<StateId> follows;
+	std::vector<char> accepting;
+	for (const auto& [input, target] : positions)
+	{
+		bool isAccepting = false;
+		for (const auto state : closures.GetClosure(target))
+		{
+			isAccepting = isAccepting || GetOutputIdForState(state) == oneOutput;
+			for (const auto& edge : m_edges[state])
 			{
-				return std::nullopt;
+				if (edge.input != EPSILON_ID)
+				{
+					follows.push_back(positionIds.at({ edge.input, edge.to }));
+				}
 			}
 		}
+		positionInputs.push_back(input);
+		firstFollow.push_back(follows.size());
+		accepting.push_back(isAccepting);
 	}
-	return finalOutput;
+
+	return { positionInputs, firstFollow, follows, accepting, m_inputs.Size(), oneOutput, zeroOutput };
 }
 
-void MooreMachine::RemoveUnreachableStates()
+std::optional<Machine::OutputId> MooreMachine::GetConsistentOutput(
+	const std::vector<StateId>& states, SymbolTable& outputs) const
 {
-	if (m_initialState.empty() || m_states.empty())
+	if (states.empty())
 	{
-		Clear();
-		return;
+		return std::nullopt;
 	}
 
-	std::set<State> reachableStates;
-	std::queue<State> queue;
-
-	std::set<State> initialClosure = EpsilonClosure({ m_initialState });
-	for (const auto& state : initialClosure)
+	// Subsets hold few distinct outputs, so those are merged instead of every state.
+	std::vector<OutputId> distinct;
+	for (const auto state : states)
 	{
-		queue.push(state);
-		reachableStates.insert(state);
+		const auto output = GetOutputIdForState(state);
+		if (std::ranges::find(distinct, output) == distinct.end())
+		{
+			distinct.push_back(output);
+		}
 	}
-
-	while (!queue.empty())
+	if (distinct.size() == 1)
 	{
-		State current = queue.front();
-		queue.pop();
+		return distinct.front();
+	}
 
-		std::vector<Input> allInputs = m_inputs;
-		allInputs.push_back(EPSILON);
+	const auto zeroOutput = m_outputs.Find("0");
+	const auto oneOutput = m_outputs.Find("1");
+	if (std::ranges::all_of(distinct, [&](const OutputId output) {
+			return output == zeroOutput || output == oneOutput;
+		}))
+	{
+		return oneOutput;
+	}
 
-		for (const auto& input : allInputs)
+	std::vector<size_t> patterns;
+	for (const auto output : distinct)
+	{
+		const auto& name = m_outputs.GetName(output);
+		if (name.size() < 2 || name.front() != '{' || name.back() != '}')
 		{
-			if (!HasTransition(current, input))
-			{
-				continue;
-			}
-			for (const auto& next : GetNextStates(current, input))
-			{
-				if (reachableStates.contains(next))
-				{
-					continue;
-				}
-				reachableStates.insert(next);
-				queue.push(next);
-			}
+			return std::nullopt;
 		}
+		const auto matched = GetMatchedPatterns(name);
+		patterns.insert(patterns.end(), matched.begin(), matched.end());
 	}
+	std::ranges::sort(patterns);
+	patterns.erase(std::unique(patterns.begin(), patterns.end()), patterns.end());
+	return outputs.Intern(GetPatternSetName(patterns));
+}
 
-	std::vector<State> newStates;
-	std::unordered_map<State, Output> newStateOutputs;
-	for (const auto& state : m_states)
+std::vector<size_t> MooreMachine::GetMatchedPatterns(const std::string_view output)
+{
+	std::vector<size_t> patterns;
+	if (output.size() < 2 || output.front() != '{' || output.back() != '}')
 	{
-		if (!reachableStates.contains(state))
+		return patterns;
+	}
+	size_t pattern = 0;
+	bool hasDigits = false;
+	for (const auto c : output.substr(1))
+	{
+		if (std::isdigit(static_cast<unsigned char>(c)))
 		{
-			continue;
+			pattern = pattern * 10 + (c - '0');
+			hasDigits = true;
 		}
-		newStates.push_back(state);
-		if (!m_stateOutputs.contains(state))
+		else if (hasDigits)
 		{
-			continue;
+			patterns.push_back(pattern);
+			pattern = 0;
+			hasDigits = false;
 		}
-		newStateOutputs[state] = m_stateOutputs.at(state);
 	}
-	m_states = newStates;
-	m_stateOutputs = newStateOutputs;
+	return patterns;
+}
 
-	TransitionMap newTransitions;
-	for (const auto& [from, transitions] : m_transitions)
+void MooreMachine::RemoveUnreachableStates()
+{
+	if (m_initialState == NO_ID || m_states.Empty())
 	{
-		if (!reachableStates.contains(from))
-		{
-			continue;
-		}
+		Clear();
+		return;
+	}
 
-		newTransitions[from] = {};
-		for (const auto& [input, nextStates] : transitions)
+	const auto oldToNew = CompactStates(GetReachableStates());
+
+	std::vector<OutputId> newStateOutputs(m_states.Size(), NO_ID);
+	for (StateId state = 0; state < oldToNew.size(); ++state)
+	{
+		if (oldToNew[state] != NO_ID)
 		{
-			for (const auto& next : nextStates)
-			{
-				if (reachableStates.contains(next))
-				{
-					newTransitions[from][input].push_back(next);
-				}
-			}
+			newStateOutputs[oldToNew[state]] = GetStateOutputId(state);
 		}
 	}
-	m_transitions = newTransitions;
+	m_stateOutputs = std::move(newStateOutputs);
 }
 
 void MooreMachine::FromGrammar(const std::string& fileName)
 {
-	std::ifstream file(fileName);
-	AssertInputIsOpen(file, fileName);
-
-	GrammarComponents grammar = ParseGrammarFile(file);
-	file.close();
+	const MappedFile file(fileName);
+	const GrammarComponents grammar = ParseGrammarFile(file.GetText());
 
 	GrammarType type = DetectGrammarType(grammar);
 	switch (type)
@@ -718,10 +855,8 @@ void MooreMachine::FromGrammar(const std::string& fileName)
 
 void MooreMachine::FromRightGrammar(const std::string& fileName)
 {
-	std::ifstream file(fileName);
-	AssertInputIsOpen(file, fileName);
-	GrammarComponents grammar = ParseGrammarFile(file);
-	file.close();
+	const MappedFile file(fileName);
+	const GrammarComponents grammar = ParseGrammarFile(file.GetText());
 	BuildNFAFromRightGrammar(grammar);
 
 	std::unique_ptr<Machine> dfa_ptr = this->GetDeterministic();
@@ -736,35 +871,70 @@ void MooreMachine::FromRightGrammar(const std::string& fileName)
 	}
 }
 
-MooreMachine::GrammarComponents MooreMachine::ParseGrammarFile(std::ifstream& file)
+MooreMachine::GrammarComponents MooreMachine::ParseGrammarFile(const std::string_view text)
 {
-	const std::regex startRegex(R"(^\s*START\s*:\s*(\w+)\s*$)");
-	const std::regex ruleRegex(R"(^\s*(\w+)\s*->\s*(.*)$)");
-
 	GrammarComponents grammar;
-	std::string line;
 
-	while (std::getline(file, line))
+	size_t lineStart = 0;
+	while (lineStart < text.size())
 	{
-		line.erase(0, line.find_first_not_of(" \t"));
-		line.erase(line.find_last_not_of(" \t") + 1);
-		if (line.empty() || line.substr(0, 2) == "//")
+		auto lineEnd = text.find('\n', lineStart);
+		if (lineEnd == std::string_view::npos)
+		{
+			lineEnd = text.size();
+		}
+		auto line = text.substr(lineStart, lineEnd - lineStart);
+		lineStart = lineEnd + 1;
+
+		SkipGrammarSpaces(line);
+		if (line.empty() || line.starts_with("//"))
+		{
+			continue;
+		}
+
+		const auto head = ReadGrammarWord(line);
+		if (head.empty())
 		{
 			continue;
 		}
+		SkipGrammarSpaces(line);
 
-		std::smatch match;
-		if (std::regex_match(line, match, startRegex))
+		if (head == "START" && line.starts_with(':'))
 		{
-			grammar.startSymbol = match[1];
+			line.remove_prefix(1);
+			const auto symbol = ReadGrammarWord(line);
+			SkipGrammarSpaces(line);
+			if (!symbol.empty() && line.empty())
+			{
+				grammar.startSymbol = symbol;
+				continue;
+			}
 		}
-		else if (std::regex_match(line, match, ruleRegex))
+		if (!line.starts_with("->"))
 		{
-			State fromState = match[1];
-			std::string rhs = match[2];
+			continue;
+		}
+		line.remove_prefix(2);
+		SkipGrammarSpaces(line);
+
+		grammar.nonTerminals.insert(head);
 
-			grammar.nonTerminals.insert(fromState);
-			grammar.rules.emplace_back(fromState, rhs);
+		GrammarRule rule{ head, line, {}, 0 };
+		while (rule.symbolCount < rule.symbols.size())
+		{
+			const auto symbol = ReadGrammarWord(line);
+			if (symbol.empty())
+			{
+				break;
+			}
+			rule.symbols[rule.symbolCount++] = symbol;
+		}
+		SkipGrammarSpaces(line);
+		// Bodies other than "", "a", "B", "a B" or "B a" cannot appear in a regular grammar and are skipped.
+		if (line.empty())
+		{
+			rule.body.remove_suffix(rule.body.size() - rule.body.find_last_not_of(" \t\r") - 1);
+			grammar.rules.push_back(rule);
 		}
 	}
 
@@ -777,23 +947,14 @@ MooreMachine::GrammarComponents MooreMachine::ParseGrammarFile(std::ifstream& fi
 
 MooreMachine::GrammarType MooreMachine::DetectGrammarType(const GrammarComponents& grammar)
 {
-	const std::regex twoSymbolsRegex(R"(^\s*(\w+)\s+(\w+)\s*$)");
-	const std::regex oneSymbolRegex(R"(^\s*(\w+)\s*$)");
-
 	auto detectedType = GrammarType::UNKNOWN;
 
 	for (const auto& rule : grammar.rules)
 	{
-		const std::string& rhs = rule.second;
-		std::smatch match;
-
-		if (std::regex_match(rhs, match, twoSymbolsRegex))
+		if (rule.symbolCount == 2)
 		{
-			State symbolX = match[1];
-			State symbolY = match[2];
-
-			bool xIsNT = grammar.nonTerminals.contains(symbolX);
-			bool yIsNT = grammar.nonTerminals.contains(symbolY);
+			bool xIsNT = grammar.nonTerminals.contains(rule.symbols[0]);
+			bool yIsNT = grammar.nonTerminals.contains(rule.symbols[1]);
 
 			if (!xIsNT && yIsNT)
 			{
@@ -813,7 +974,7 @@ MooreMachine::GrammarType MooreMachine::DetectGrammarType(const GrammarComponent
 			}
 			else
 			{
-				throw std::runtime_error("Grammar error: Rule '" + rule.first + " -> " + rhs + "' is not regular.");
+				throw std::runtime_error("Grammar error: Rule '" + std::string(rule.head) + " -> " + std::string(rule.body) + "' is not regular.");
 			}
 		}
 	}
@@ -823,13 +984,7 @@ MooreMachine::GrammarType MooreMachine::DetectGrammarType(const GrammarComponent
 
 void MooreMachine::BuildNFAFromRightGrammar(const GrammarComponents& grammar)
 {
-	const std::regex rhsTransitionRegex(R"(^\s*(\w+)\s+(\w+)\s*$)");
-	const std::regex rhsSingleSymbolRegex(R"(^\s*(\w+)\s*$)");
-	const std::regex rhsEpsilonRegex(R"(^\s*$)");
-
 	Clear();
-	m_initialState = grammar.startSymbol;
-	m_currentState = grammar.startSymbol;
 	AddStateOutput(F_STATE, "1");
 
 	for (const auto& nt : grammar.nonTerminals)
@@ -837,20 +992,20 @@ void MooreMachine::BuildNFAFromRightGrammar(const GrammarComponents& grammar)
 		if (nt != F_STATE)
 			AddStateOutput(nt, "0");
 	}
+	m_initialState = AddState(grammar.startSymbol);
+	m_currentState = m_initialState;
 
 	for (const auto& rule : grammar.rules)
 	{
-		const State& fromState = rule.first;
-		const std::string& rhs = rule.second;
-		std::smatch match;
+		const auto fromState = rule.head;
 
-		if (std::regex_match(rhs, match, rhsTransitionRegex)) // A -> a B
+		if (rule.symbolCount == 2) // A -> a B
 		{
-			AddTransition(fromState, match[1], match[2]);
+			AddTransition(fromState, rule.symbols[0], rule.symbols[1]);
 		}
-		else if (std::regex_match(rhs, match, rhsSingleSymbolRegex))
+		else if (rule.symbolCount == 1)
 		{
-			State symbol = match[1];
+			const auto symbol = rule.symbols[0];
 			if (grammar.nonTerminals.contains(symbol)) // A -> B
 			{
 				AddTransition(fromState, EPSILON, symbol);
@@ -860,12 +1015,12 @@ void MooreMachine::BuildNFAFromRightGrammar(const GrammarComponents& grammar)
 				AddTransition(fromState, symbol, F_STATE);
 			}
 		}
-		else if (std::regex_match(rhs, match, rhsEpsilonRegex)) // A ->
+		else // A ->
 		{
 			AddTransition(fromState, EPSILON, F_STATE);
-			if (fromState == m_initialState)
+			if (fromState == grammar.startSymbol)
 			{
-				AddStateOutput(m_initialState, "1");
+				AddStateOutput(grammar.startSymbol, "1");
 			}
 		}
 	}
@@ -873,10 +1028,8 @@ void MooreMachine::BuildNFAFromRightGrammar(const GrammarComponents& grammar)
 
 void MooreMachine::FromLeftGrammar(const std::string& fileName)
 {
-	std::ifstream file(fileName);
-	AssertInputIsOpen(file, fileName);
-	GrammarComponents grammar = ParseGrammarFile(file);
-	file.close();
+	const MappedFile file(fileName);
+	const GrammarComponents grammar = ParseGrammarFile(file.GetText());
 
 	BuildNFAFromLeftGrammar(grammar);
 
@@ -893,14 +1046,10 @@ void MooreMachine::FromLeftGrammar(const std::string& fileName)
 
 void MooreMachine::BuildNFAFromLeftGrammar(const GrammarComponents& grammar)
 {
-	const std::regex rhsTransitionRegex(R"(^\s*(\w+)\s+(\w+)\s*$)");
-	const std::regex rhsSingleSymbolRegex(R"(^\s*(\w+)\s*$)");
-	const std::regex rhsEpsilonRegex(R"(^\s*$)");
-
 	Clear();
-	m_initialState = S_START;
-	m_currentState = S_START;
 	AddStateOutput(S_START, "0");
+	m_initialState = FindState(S_START);
+	m_currentState = m_initialState;
 	AddStateOutput(grammar.startSymbol, "1");
 
 	for (const auto& nt : grammar.nonTerminals)
@@ -913,17 +1062,15 @@ void MooreMachine::BuildNFAFromLeftGrammar(const GrammarComponents& grammar)
 
 	for (const auto& rule : grammar.rules)
 	{
-		const State& toState = rule.first;
-		const std::string& rhs = rule.second;
-		std::smatch match;
+		const auto toState = rule.head;
 
-		if (std::regex_match(rhs, match, rhsTransitionRegex)) // A -> B a
+		if (rule.symbolCount == 2) // A -> B a
 		{
-			AddTransition(match[1], match[2], toState);
+			AddTransition(rule.symbols[0], rule.symbols[1], toState);
 		}
-		else if (std::regex_match(rhs, match, rhsSingleSymbolRegex))
+		else if (rule.symbolCount == 1)
 		{
-			State symbol = match[1];
+			const auto symbol = rule.symbols[0];
 			if (grammar.nonTerminals.contains(symbol)) // A -> B
 			{
 				AddTransition(symbol, EPSILON, toState);
@@ -933,53 +1080,131 @@ void MooreMachine::BuildNFAFromLeftGrammar(const GrammarComponents& grammar)
 				AddTransition(S_START, symbol, toState);
 			}
 		}
-		else if (std::regex_match(rhs, match, rhsEpsilonRegex)) // A ->
+		else // A ->
 		{
 			AddTransition(S_START, EPSILON, toState);
 		}
 	}
 }
 
-void MooreMachine::FromRegular(const std::string& regular)
+void MooreMachine::FromRegular(const std::string& regular, const RegularConstruction construction)
 {
 	Clear();
 
 	if (regular.empty())
 	{
-		m_initialState = "S0";
+		AddStateOutput("S0", "1");
+		m_initialState = FindState("S0");
 		m_currentState = m_initialState;
-		AddStateOutput(m_initialState, "1");
 		return;
 	}
 
-	std::string expr;
-	for (const auto c : regular)
+	m_regularConstruction = construction;
+	try
 	{
-		if (c == ' ')
+		RegularTree tree;
+		const auto root = tree.Parse(regular);
+		AddByteClassInputs(tree, { &root, 1 });
+
+		std::vector<bool> isAccepting;
+		if (construction == RegularConstruction::DERIVATIVES)
 		{
-			continue;
+			isAccepting = BuildDFAFromDerivatives(tree, root);
+		}
+		else if (construction == RegularConstruction::GLUSHKOV)
+		{
+			isAccepting = BuildGlushkovNFA(tree, tree.Simplify(root));
 		}
-		expr += c;
+		else
+		{
+			const auto fragment = BuildNFAFromTree(tree, tree.Simplify(root));
+			m_initialState = FindState(fragment.startState);
+			isAccepting.assign(m_states.Size(), false);
+			isAccepting[FindState(fragment.acceptState)] = true;
+		}
+		SetAcceptingOutputs(isAccepting);
 	}
-
-	try
+	catch (const std::exception& e)
 	{
-		auto [startState, acceptState] = BuildNFAFromReg(expr);
+		Clear();
+		throw std::runtime_error("Invalid regular expression: " + std::string(e.what()));
+	}
+}
 
-		m_initialState = startState;
-		m_currentState = startState;
+void MooreMachine::FromRegular(const std::vector<std::string>& patterns, const RegularConstruction construction)
+{
+	if (construction == RegularConstruction::DERIVATIVES && patterns.size() != 1)
+	{
+		throw std::runtime_error("Derivatives build a machine for a single pattern only.");
+	}
+	Clear();
 
-		for (const auto& state : m_states)
+	m_regularConstruction = construction;
+	try
+	{
+		// One tree for all the patterns, so their byte classes refine the classes of each one.
+		RegularTree tree;
+		std::vector<RegularTree::Id> roots;
+		for (const auto& pattern : patterns)
+		{
+			roots.push_back(tree.Parse(pattern));
+		}
+		AddByteClassInputs(tree, roots);
+
+		std::vector<std::vector<size_t>> accepted;
+		const auto accept = [&accepted](const StateId state, const size_t pattern) {
+			accepted.resize(std::max<size_t>(accepted.size(), state + 1));
+			accepted[state].push_back(pattern);
+		};
+		if (construction == RegularConstruction::DERIVATIVES)
 		{
-			if (state == acceptState)
+			const auto isAccepting = BuildDFAFromDerivatives(tree, roots.front());
+			for (StateId state = 0; state < isAccepting.size(); ++state)
 			{
-				AddStateOutput(state, "1");
+				if (isAccepting[state])
+				{
+					accept(state, 0);
+				}
 			}
-			else
+		}
+		else
+		{
+			// A start of its own links to every pattern, like S0 links to the positions of one.
+			m_initialState = AddState(GenerateNewState());
+			for (size_t pattern = 0; pattern < roots.size(); ++pattern)
 			{
-				AddStateOutput(state, "0");
+				const auto fragment = BuildNFAFromTree(tree, tree.Simplify(roots[pattern]));
+				if (construction == RegularConstruction::GLUSHKOV)
+				{
+					for (const auto position : fragment.first)
+					{
+						AddPositionEdges(m_initialState, position);
+					}
+					if (fragment.isNullable)
+					{
+						accept(m_initialState, pattern);
+					}
+					for (const auto position : fragment.last)
+					{
+						accept(position, pattern);
+					}
+				}
+				else
+				{
+					AddTransition(m_initialState, EPSILON_ID, FindState(fragment.startState));
+					accept(FindState(fragment.acceptState), pattern);
+				}
 			}
 		}
+		m_currentState = m_initialState;
+		m_glushkovPositions.clear();
+
+		accepted.resize(m_states.Size());
+		for (StateId state = 0; state < m_states.Size(); ++state)
+		{
+			SetStateOutput(state, m_outputs.Intern(GetPatternSetName(accepted[state])));
+		}
+		CompressInputs();
 	}
 	catch (const std::exception& e)
 	{
@@ -988,132 +1213,241 @@ void MooreMachine::FromRegular(const std::string& regular)
 	}
 }
 
-MooreMachine::NFAFragment MooreMachine::BuildNFAFromReg(const std::string& expr)
+void MooreMachine::AddByteClassInputs(const RegularTree& tree, const std::span<const RegularTree::Id> roots)
 {
-	ValidateRegex(expr);
-	size_t pos = 0;
-	return ParseAlternation(expr, pos);
+	// One input per byte class, so a class or range is a single edge however many bytes it has.
+	m_byteClasses = tree.ClassifyBytes(roots);
+	std::vector<std::vector<unsigned char>> classBytes;
+	for (size_t byte = 0; byte < m_byteClasses.size(); ++byte)
+	{
+		if (m_byteClasses[byte] != NO_ID)
+		{
+			classBytes.resize(std::max<size_t>(classBytes.size(), m_byteClasses[byte] + 1));
+			classBytes[m_byteClasses[byte]].push_back(static_cast<unsigned char>(byte));
+		}
+	}
+	for (const auto& bytes : classBytes)
+	{
+		AddInput(GetBytesName(bytes));
+	}
 }
 
-MooreMachine::NFAFragment MooreMachine::ParseAlternation(const std::string& expr, size_t& pos)
+std::optional<CountingAutomaton> MooreMachine::FromRegularWithCounters(
+	const std::string& regular, const size_t unrollLimit)
 {
-	auto result = ParseConcatenation(expr, pos);
+	Clear();
 
-	while (pos < expr.length() && expr[pos] == '|')
+	m_regularConstruction = RegularConstruction::GLUSHKOV;
+	try
+	{
+		RegularTree tree;
+		const auto parsed = tree.Parse(regular);
+		const auto root = tree.Simplify(parsed);
+		// The start is a position of its own on top of those of the tree.
+		m_isCountingRepetitions = CountGlushkovPositions(tree, root, false) >= unrollLimit;
+		if (m_isCountingRepetitions && CountGlushkovPositions(tree, root, true) >= CountingAutomaton::MAX_POSITIONS)
+		{
+			throw std::runtime_error(
+				"Expression needs more than " + std::to_string(CountingAutomaton::MAX_POSITIONS) + " positions");
+		}
+
+		AddByteClassInputs(tree, { &parsed, 1 });
+		const auto isAccepting = BuildGlushkovNFA(tree, root);
+		if (!m_isCountingRepetitions)
+		{
+			SetAcceptingOutputs(isAccepting);
+			return std::nullopt;
+		}
+
+		// Inputs are still the byte classes, CompressInputs has not merged any.
+		std::vector<CountingAutomaton::Position> positions(m_states.Size());
+		for (StateId state = 0; state < m_states.Size(); ++state)
+		{
+			auto& position = positions[state];
+			if (state != m_initialState)
+			{
+				position.inputs = m_glushkovPositions[state].inputs;
+				position.min = m_glushkovPositions[state].min;
+				position.max = m_glushkovPositions[state].max;
+			}
+			for (const auto& edge : m_edges[state])
+			{
+				position.follows.push_back(edge.to);
+			}
+			position.isLast = isAccepting[state];
+		}
+		CountingAutomaton automaton(m_byteClasses, std::move(positions));
+		Clear();
+		m_glushkovPositions.clear();
+		m_isCountingRepetitions = false;
+		return automaton;
+	}
+	catch (const std::exception& e)
 	{
-		pos++;
-		auto right = ParseConcatenation(expr, pos);
-		result = CreateAlternationNFA(result, right);
+		Clear();
+		m_glushkovPositions.clear();
+		m_isCountingRepetitions = false;
+		throw std::runtime_error("Invalid regular expression: " + std::string(e.what()));
 	}
-	return result;
 }
 
-MooreMachine::NFAFragment MooreMachine::ParseConcatenation(const std::string& expr, size_t& pos)
+std::vector<bool> MooreMachine::BuildDFAFromDerivatives(const RegularTree& tree, const RegularTree::Id root)
 {
-	auto result = ParseElement(expr, pos);
+	// The inputs of the terms are the byte classes of the machine.
+	RegularExpression terms;
+	const auto start = terms.FromTree(tree, root, m_byteClasses);
+
+	// Every distinct derivative is a state. Normal forms absorb the empty term, so all states
+	// other than it can still accept and it is left out as a missing transition.
+	std::unordered_map<RegularExpression::Id, StateId> states = { { start, AddState(GenerateNewState()) } };
+	std::vector<RegularExpression::Id> order = { start };
+	std::vector<bool> isAccepting;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		const auto term = order[i];
+		const auto from = states[term];
+		isAccepting.push_back(terms.IsNullable(term));
+		for (InputId input = 0; input < m_inputs.Size(); ++input)
+		{
+			const auto derivative = terms.Derivative(term, input);
+			if (derivative == RegularExpression::EMPTY)
+			{
+				continue;
+			}
+			const auto [it, isNew] = states.try_emplace(derivative, static_cast<StateId>(m_states.Size()));
+			if (isNew)
+			{
+				AddState(GenerateNewState());
+				order.push_back(derivative);
+			}
+			AddTransition(from, input, it->second);
+		}
+	}
+	m_initialState = states[start];
+	return isAccepting;
+}
 
-	while (pos < expr.length() && expr[pos] != ')' && expr[pos] != '|')
+std::vector<bool> MooreMachine::BuildGlushkovNFA(const RegularTree& tree, const RegularTree::Id root)
+{
+	// The start comes first as S0, the positions follow as S1...Sn.
+	m_initialState = AddState(GenerateNewState());
+	const auto fragment = BuildNFAFromTree(tree, root);
+	for (const auto position : fragment.first)
 	{
-		auto right = ParseElement(expr, pos);
-		result = CreateConcatenationNFA(result, right);
+		AddPositionEdges(m_initialState, position);
 	}
 
-	return result;
+	std::vector<bool> isAccepting(m_states.Size(), false);
+	isAccepting[m_initialState] = fragment.isNullable;
+	for (const auto position : fragment.last)
+	{
+		isAccepting[position] = true;
+	}
+	return isAccepting;
 }
 
-MooreMachine::NFAFragment MooreMachine::ParseElement(const std::string& expr, size_t& pos)
+void MooreMachine::SetAcceptingOutputs(const std::vector<bool>& isAccepting)
 {
-	auto result = ParseAtom(expr, pos);
-
-	while (pos < expr.length() && expr[pos] == '*')
+	m_currentState = m_initialState;
+	m_glushkovPositions.clear();
+	for (StateId state = 0; state < m_states.Size(); ++state)
 	{
-		pos++;
-		result = CreateStarNFA(result);
+		SetStateOutput(state, m_outputs.Intern(isAccepting[state] ? "1" : "0"));
 	}
-
-	return result;
+	CompressInputs();
 }
 
-// MooreMachine::NFAFragment MooreMachine::ParseAtom(const std::string& expr, size_t& pos)
-// {
-// 	if (pos >= expr.length())
-// 	{
-// 		throw std::runtime_error("Unexpected end of expression");
-// 	}
-//
-// 	if (expr[pos] == '(')
-// 	{
-// 		pos++;
-// 		auto result = ParseAlternation(expr, pos);
-//
-// 		if (pos >= expr.length() || expr[pos] != ')')
-// 		{
-// 			throw std::runtime_error("Expected closing parenthesis");
-// 		}
-// 		pos++;
-// 		return result;
-// 	}
-//
-// 	std::string inputStr;
-// 	if (expr[pos] == 'e' && (pos + 1 == expr.length() || IsCharSpecial(expr[pos + 1])))
-// 	{
-// 		inputStr = EPSILON;
-// 		pos++;
-// 	}
-// 	else
-// 	{
-// 		inputStr = std::string(1, expr[pos]);
-// 		pos++;
-//
-// 		while (pos < expr.length() && !IsCharSpecial(expr[pos]) && expr[pos] != ' ')
-// 		{
-// 			inputStr += expr[pos];
-// 			pos++;
-// 		}
-// 	}
-// 	return GenerateNewStates(inputStr);
-// }
-
-MooreMachine::NFAFragment MooreMachine::ParseAtom(const std::string& expr, size_t& pos)
+MooreMachine::NFAFragment MooreMachine::BuildNFAFromTree(const RegularTree& tree, const RegularTree::Id root)
 {
-	if (pos >= expr.length())
+	const auto& node = tree.GetNode(root);
+	switch (node.kind)
+	{
+	case RegularTree::Kind::CLASS:
 	{
-		throw std::runtime_error("Unexpected end of expression");
+		std::vector<InputId> inputs;
+		for (size_t byte = 0; byte < node.bytes.size(); ++byte)
+		{
+			if (node.bytes[byte] && std::ranges::find(inputs, m_byteClasses[byte]) == inputs.end())
+			{
+				inputs.push_back(m_byteClasses[byte]);
+			}
+		}
+		return GenerateNewStates(inputs);
 	}
-
-	if (expr[pos] == '(')
+	case RegularTree::Kind::CONCATENATION:
+	case RegularTree::Kind::ALTERNATION:
 	{
-		pos++;
-		auto result = ParseAlternation(expr, pos);
-
-		if (pos >= expr.length() || expr[pos] != ')')
+		auto result = BuildNFAFromTree(tree, node.children.front());
+		for (size_t i = 1; i < node.children.size(); ++i)
 		{
-			throw std::runtime_error("Expected closing parenthesis");
+			const auto operand = BuildNFAFromTree(tree, node.children[i]);
+			result = node.kind == RegularTree::Kind::CONCATENATION
+				? CreateConcatenationNFA(result, operand)
+				: CreateAlternationNFA(result, operand);
 		}
-		pos++;
 		return result;
 	}
-
-	std::string inputStr;
-	if (expr[pos] == 'e' && (pos + 1 == expr.length() || IsCharSpecial(expr[pos + 1])))
+	case RegularTree::Kind::REPETITION:
 	{
-		inputStr = EPSILON;
-		pos++;
+		if (m_isCountingRepetitions && IsCountedRepetition(tree, root))
+		{
+			// One position with a counter instead of the copies, see CountingAutomaton.
+			auto result = BuildNFAFromTree(tree, node.children.front());
+			auto& position = m_glushkovPositions[result.first.front()];
+			position.min = node.min;
+			position.max = node.max;
+			result.isNullable = node.min == 0;
+			return result;
+		}
+		// The repeated tree only adds states from here on, and nothing links to them yet.
+		const auto firstState = static_cast<StateId>(m_states.Size());
+		const auto result = BuildNFAFromTree(tree, node.children.front());
+		if (node.max == RegularTree::UNBOUNDED && node.min <= 1)
+		{
+			return node.min == 0 ? CreateStarNFA(result) : CreatePlusNFA(result);
+		}
+		if (node.min == 0 && node.max == 1)
+		{
+			return CreateOptionalNFA(result);
+		}
+		return CreateRepetitionNFA(result, firstState, node.min, node.max);
 	}
-	else
-	{
-		inputStr = std::string(1, expr[pos]);
-		pos++;
+	case RegularTree::Kind::EPSILON:
+		break;
 	}
-	return GenerateNewStates(inputStr);
+	return GenerateNewStates({});
 }
 
-MooreMachine::NFAFragment MooreMachine::GenerateNewStates(const Input& input)
+MooreMachine::NFAFragment MooreMachine::GenerateNewStates(const std::vector<InputId>& inputs)
 {
+	if (m_regularConstruction == RegularConstruction::GLUSHKOV)
+	{
+		NFAFragment fragment;
+		fragment.isNullable = inputs.empty();
+		if (!fragment.isNullable)
+		{
+			const auto position = AddState(GenerateNewState());
+			m_glushkovPositions.resize(position + 1);
+			m_glushkovPositions[position] = { inputs };
+			fragment.first = { position };
+			fragment.last = { position };
+		}
+		return fragment;
+	}
+
 	const auto start = GenerateNewState();
 	const auto accept = GenerateNewState();
+	const auto startId = AddState(start);
+	const auto acceptId = AddState(accept);
 
-	AddTransition(start, input, accept);
+	if (inputs.empty())
+	{
+		AddTransition(startId, EPSILON_ID, acceptId);
+	}
+	for (const auto input : inputs)
+	{
+		AddTransition(startId, input, acceptId);
+	}
 
 	return {
 		start,
@@ -1123,6 +1457,16 @@ MooreMachine::NFAFragment MooreMachine::GenerateNewStates(const Input& input)
 
 MooreMachine::NFAFragment MooreMachine::CreateAlternationNFA(const NFAFragment& a, const NFAFragment& b)
 {
+	if (m_regularConstruction == RegularConstruction::GLUSHKOV)
+	{
+		// The positions of a and b are disjoint, so appending needs no deduplication.
+		NFAFragment fragment = a;
+		fragment.first.insert(fragment.first.end(), b.first.begin(), b.first.end());
+		fragment.last.insert(fragment.last.end(), b.last.begin(), b.last.end());
+		fragment.isNullable = a.isNullable || b.isNullable;
+		return fragment;
+	}
+
 	const auto start = GenerateNewState();
 	const auto accept = GenerateNewState();
 
@@ -1140,6 +1484,31 @@ MooreMachine::NFAFragment MooreMachine::CreateAlternationNFA(const NFAFragment&
 
 MooreMachine::NFAFragment MooreMachine::CreateConcatenationNFA(const NFAFragment& a, const NFAFragment& b)
 {
+	if (m_regularConstruction == RegularConstruction::GLUSHKOV)
+	{
+		for (const auto from : a.last)
+		{
+			for (const auto to : b.first)
+			{
+				AddPositionEdges(from, to);
+			}
+		}
+
+		NFAFragment fragment;
+		fragment.first = a.first;
+		if (a.isNullable)
+		{
+			fragment.first.insert(fragment.first.end(), b.first.begin(), b.first.end());
+		}
+		fragment.last = b.last;
+		if (b.isNullable)
+		{
+			fragment.last.insert(fragment.last.end(), a.last.begin(), a.last.end());
+		}
+		fragment.isNullable = a.isNullable && b.isNullable;
+		return fragment;
+	}
+
 	AddTransition(a.acceptState, EPSILON, b.startState);
 
 	return {a.startState, b.acceptState};
@@ -1147,6 +1516,21 @@ MooreMachine::NFAFragment MooreMachine::CreateConcatenationNFA(const NFAFragment
 
 MooreMachine::NFAFragment MooreMachine::CreateStarNFA(const NFAFragment& fragment)
 {
+	if (m_regularConstruction == RegularConstruction::GLUSHKOV)
+	{
+		for (const auto from : fragment.last)
+		{
+			for (const auto to : fragment.first)
+			{
+				AddPositionEdges(from, to);
+			}
+		}
+
+		auto result = fragment;
+		result.isNullable = true;
+		return result;
+	}
+
 	const auto start = GenerateNewState();
 	const auto accept = GenerateNewState();
 
@@ -1162,54 +1546,144 @@ MooreMachine::NFAFragment MooreMachine::CreateStarNFA(const NFAFragment& fragmen
 	};
 }
 
-Machine::State MooreMachine::GenerateNewState()
+MooreMachine::NFAFragment MooreMachine::CreatePlusNFA(const NFAFragment& fragment)
 {
-	return "S" + std::to_string(m_stateCounter++);
+	if (m_regularConstruction == RegularConstruction::GLUSHKOV)
+	{
+		for (const auto from : fragment.last)
+		{
+			for (const auto to : fragment.first)
+			{
+				AddPositionEdges(from, to);
+			}
+		}
+		return fragment;
+	}
+
+	const auto start = GenerateNewState();
+	const auto accept = GenerateNewState();
+
+	AddTransition(start, EPSILON, fragment.startState);
+
+	AddTransition(fragment.acceptState, EPSILON, fragment.startState);
+	AddTransition(fragment.acceptState, EPSILON, accept);
+
+	return {
+		start,
+		accept,
+	};
 }
 
-bool IsCharSpecial(const char c)
+MooreMachine::NFAFragment MooreMachine::CreateOptionalNFA(const NFAFragment& fragment)
 {
-	return c == '(' || c == ')' || c == '*' || c == '|' || c == 'e';
+	if (m_regularConstruction == RegularConstruction::GLUSHKOV)
+	{
+		auto result = fragment;
+		result.isNullable = true;
+		return result;
+	}
+
+	const auto start = GenerateNewState();
+	const auto accept = GenerateNewState();
+
+	AddTransition(start, EPSILON, accept);
+	AddTransition(start, EPSILON, fragment.startState);
+
+	AddTransition(fragment.acceptState, EPSILON, accept);
+
+	return {
+		start,
+		accept,
+	};
 }
 
-void ValidateRegex(const std::string& expr)
+MooreMachine::NFAFragment MooreMachine::CreateRepetitionNFA(
+	const NFAFragment& fragment,
+	const StateId firstState,
+	const size_t min,
+	const size_t max)
 {
-	int parenCount = 0;
+	const auto isUnbounded = max == RegularTree::UNBOUNDED;
+	const auto copyCount = isUnbounded ? std::max<size_t>(min, 1) : max;
+	if (copyCount == 0)
+	{
+		// The states of the fragment stay behind unreachable.
+		return GenerateNewStates({});
+	}
 
-	for (size_t i = 0; i < expr.length(); ++i)
+	// Copies are taken from the built states, the text of the atom is not parsed again.
+	const auto endState = static_cast<StateId>(m_states.Size());
+	std::vector<NFAFragment> copies = { fragment };
+	while (copies.size() < copyCount)
 	{
-		char c = expr[i];
+		copies.push_back(CopyFragment(fragment, firstState, endState));
+	}
 
-		if (c == '(')
-		{
-			parenCount++;
-		}
-		else if (c == ')')
+	// r{2,} is r r+ and r{2,4} is r r (r (r)?)?, so the optional copies need no epsilon fan out.
+	std::optional<NFAFragment> result;
+	auto requiredCount = min;
+	if (isUnbounded)
+	{
+		result = min == 0 ? CreateStarNFA(copies.back()) : CreatePlusNFA(copies.back());
+		requiredCount = copyCount - 1;
+	}
+	for (auto i = isUnbounded ? 0 : max; i-- > min;)
+	{
+		result = CreateOptionalNFA(result ? CreateConcatenationNFA(copies[i], *result) : copies[i]);
+	}
+	for (auto i = requiredCount; i-- > 0;)
+	{
+		result = result ? CreateConcatenationNFA(copies[i], *result) : copies[i];
+	}
+	return *result;
+}
+
+MooreMachine::NFAFragment MooreMachine::CopyFragment(const NFAFragment& fragment, const StateId firstState, const StateId endState)
+{
+	const auto offset = static_cast<StateId>(m_states.Size()) - firstState;
+	for (auto state = firstState; state < endState; ++state)
+	{
+		AddState(GenerateNewState());
+	}
+	for (auto state = firstState; state < endState; ++state)
+	{
+		auto edges = m_edges[state];
+		for (auto& edge : edges)
 		{
-			parenCount--;
-			if (parenCount < 0)
-			{
-				throw std::runtime_error("Unmatched closing parenthesis");
-			}
+			edge.to += offset;
 		}
-		else if (c == '*')
+		m_edges[state + offset] = std::move(edges);
+	}
+
+	auto copy = fragment;
+	if (m_regularConstruction == RegularConstruction::GLUSHKOV)
+	{
+		m_glushkovPositions.resize(m_states.Size());
+		std::copy(m_glushkovPositions.begin() + firstState, m_glushkovPositions.begin() + endState, m_glushkovPositions.begin() + firstState + offset);
+		for (auto& position : copy.first)
 		{
-			if (i == 0 || expr[i - 1] == '(' || expr[i - 1] == '|')
-			{
-				throw std::runtime_error("Invalid use of * operator");
-			}
+			position += offset;
 		}
-		else if (c == '|')
+		for (auto& position : copy.last)
 		{
-			if (i == 0 || i == expr.length() - 1 || expr[i - 1] == '(' || expr[i + 1] == ')' || expr[i + 1] == '|' || expr[i + 1] == '*')
-			{
-				throw std::runtime_error("Invalid use of | operator");
-			}
+			position += offset;
 		}
+		return copy;
 	}
+	copy.startState = GetStateName(FindState(fragment.startState) + offset);
+	copy.acceptState = GetStateName(FindState(fragment.acceptState) + offset);
+	return copy;
+}
 
-	if (parenCount != 0)
+void MooreMachine::AddPositionEdges(const StateId from, const StateId position)
+{
+	for (const auto input : m_glushkovPositions[position].inputs)
 	{
-		throw std::runtime_error("Wrong brackets count");
+		AddTransition(from, input, position);
 	}
 }
+
+Machine::State MooreMachine::GenerateNewState()
+{
+	return "S" + std::to_string(m_stateCounter++);
+}
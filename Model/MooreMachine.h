@@ -1,9 +1,16 @@
 #pragma once
 
+#include "BitParallelNfa.h"
+#include "CountingAutomaton.h"
+#include "LazyDfa.h"
 #include "Machine.h"
+#include "RegularTree.h"
+#include "StateSetTable.h"
 
+#include <array>
 #include <optional>
 #include <set>
+#include <span>
 #include <unordered_map>
 #include <vector>
 
@@ -22,11 +29,39 @@ public:
 		MIXED_INVALID
 	};
 
-	explicit MooreMachine(State initialState = "");
+	// THOMPSON gives about two states and several epsilon edges per symbol. GLUSHKOV gives one
+	// state per symbol occurrence plus the start and no epsilon edges at all. DERIVATIVES skips the
+	// NFA and gives a DFA with one state per distinct Brzozowski derivative, often close to minimal.
+	enum class RegularConstruction
+	{
+		THOMPSON,
+		GLUSHKOV,
+		DERIVATIVES
+	};
+
+	explicit MooreMachine(const State& initialState = "");
 
 	explicit MooreMachine(MealyMachine& mealyMachine);
 
-	void FromRegular(const std::string& regular);
+	// Besides "|", "*" and parentheses, expressions take classes and ranges such as "[a-z_]", and
+	// "+", "?", "{n}", "{n,}" and "{n,m}". An empty alternative as in "(|a)" is epsilon, spaces are
+	// ignored and a backslash makes the next character literal, a space included. Inputs are the
+	// byte classes that no part of the expression tells apart, merged further by CompressInputs.
+	void FromRegular(const std::string& regular, RegularConstruction construction = RegularConstruction::THOMPSON);
+
+	// One machine for all the patterns. A state outputs the set of patterns that accept the
+	// inputs read so far, written as "{0,2}" or "{}", and GetDeterministic merges such outputs
+	// into their union, so one run reports every pattern. DERIVATIVES builds one pattern only.
+	void FromRegular(const std::vector<std::string>& patterns, RegularConstruction construction = RegularConstruction::THOMPSON);
+
+	// Indices of the patterns in an output of the multi-pattern FromRegular, empty for other outputs.
+	static std::vector<size_t> GetMatchedPatterns(std::string_view output);
+
+	// Builds with GLUSHKOV when the expression unrolls to at most unrollLimit positions, counting
+	// repetitions such as "[ab]{1000}" as that many. Otherwise the machine is left empty and the
+	// counting automaton of the expression, which keeps such repetitions as counters, is returned.
+	std::optional<CountingAutomaton> FromRegularWithCounters(
+		const std::string& regular, size_t unrollLimit = CountingAutomaton::DEFAULT_UNROLL_LIMIT);
 
 	void FromDot(const std::string& fileName) override;
 
@@ -36,17 +71,23 @@ public:
 
 	void FromLeftGrammar(const std::string& fileName);
 
-	void SaveToDot(const std::string& fileName) override;
+	void SaveToDot(const std::string& fileName, const DotOptions& options = {}) override;
+
+	void FromBinary(const std::string& fileName) override;
+
+	void SaveToBinary(const std::string& fileName) override;
 
 	bool HasTransition(const State& from, const Input& input) const override;
 
 	State GetNextState(const State& fromState, const Input& input) const override;
 
-	std::unique_ptr<Machine> GetMinimized() const override;
+	std::unique_ptr<Machine> GetMinimized(const MinimizeOptions& options = {}) const override;
 
-	void AddStateOutput(const State& state, const Output& output);
+	TransitionTable Compile() const override;
 
-	void AddTransition(const State& from, const Input& input, const State& to);
+	void AddStateOutput(std::string_view state, std::string_view output);
+
+	void AddTransition(std::string_view from, std::string_view input, std::string_view to);
 
 	Output GetOutputForState(const State& state) const;
 
@@ -56,52 +97,100 @@ public:
 
 	std::unique_ptr<Machine> GetDeterministic() const;
 
+	// Determinizes while the input runs instead of up front, keeping at most cacheSize bytes of
+	// built states. Meant for machines whose full subset construction blows up.
+	LazyDfa GetLazyDeterministic(size_t cacheSize = 16 << 20) const;
+
+	// Simulates the machine without determinizing it, for accepting machines with outputs "0"
+	// and "1" and at most BitParallelNfa::MAX_POSITIONS distinct (input, target) transitions.
+	BitParallelNfa GetBitParallel() const;
+
 	State GetInitialState() const override
 	{
-		return m_initialState;
+		return GetStateName(m_initialState);
 	}
 
 private:
+	// Names are views into the grammar file and stay valid while it is mapped.
+	struct GrammarRule
+	{
+		std::string_view head;
+		std::string_view body;
+		std::array<std::string_view, 2> symbols;
+		size_t symbolCount;
+	};
+
 	struct GrammarComponents
 	{
-		State startSymbol;
-		std::set<State> nonTerminals;
-		std::vector<std::pair<State, std::string>> rules;
+		std::string_view startSymbol;
+		std::set<std::string_view> nonTerminals;
+		std::vector<GrammarRule> rules;
+	};
+
+	// A position of the Glushkov construction: the inputs that enter it and, for a counted
+	// repetition of them, the counter bounds.
+	struct GlushkovPosition
+	{
+		std::vector<InputId> inputs;
+		size_t min = 1;
+		size_t max = 1;
 	};
 
 	struct NFAFragment
 	{
 		State startState;
 		State acceptState;
+		// Glushkov positions the fragment can begin and end with, and whether it matches the empty string.
+		std::vector<StateId> first{};
+		std::vector<StateId> last{};
+		bool isNullable = false;
 	};
 
-	using TransitionMap = std::unordered_map<State, std::unordered_map<Input, std::vector<State>>>;
-
 	void ConvertFromMealy(MealyMachine& mealy);
 
 	void Clear();
 
+	void AddTransition(StateId from, InputId input, StateId to);
+
+	void SetStateOutput(StateId state, OutputId output);
+
+	OutputId GetStateOutputId(StateId state) const;
+
+	OutputId GetOutputIdForState(StateId state) const;
+
+	// Adds an unnamed state, names are generated once the whole machine is built.
+	StateId AddGeneratedState(OutputId output);
+
 	void RemoveUnreachableStates();
 
-	std::set<State> EpsilonClosure(const std::set<State>& states) const;
+	// Output of a node given as output="out0" or in the label as "S0 / out0", "S0\\noutput: out0" or "S0\\nout0".
+	static std::optional<std::string_view> ReadDotOutput(const DotStatement& statement);
 
-	std::optional<Output> GetConsistentOutput(const std::set<State>& states) const;
+	// Outputs "0" and "1" merge to "1" and pattern sets to their union, interned into outputs,
+	// which must hold the outputs of this machine under the same ids. Others must be equal.
+	std::optional<OutputId> GetConsistentOutput(const std::vector<StateId>& states, SymbolTable& outputs) const;
+
+	// Sets up one input per byte class of the parsed trees, see RegularTree::ClassifyBytes.
+	void AddByteClassInputs(const RegularTree& tree, std::span<const RegularTree::Id> roots);
 
 	void BuildNFAFromRightGrammar(const GrammarComponents& grammar);
 
 	void BuildNFAFromLeftGrammar(const GrammarComponents& grammar);
 
-	NFAFragment BuildNFAFromReg(const std::string& expr);
-
-	NFAFragment ParseAlternation(const std::string& expr, size_t& pos);
+	// Returns whether each state accepts, the initial state is set.
+	std::vector<bool> BuildDFAFromDerivatives(const RegularTree& tree, RegularTree::Id root);
 
-	NFAFragment ParseConcatenation(const std::string& expr, size_t& pos);
+	// Builds the positions with the start as the next state and returns whether each state accepts.
+	std::vector<bool> BuildGlushkovNFA(const RegularTree& tree, RegularTree::Id root);
 
-	NFAFragment ParseElement(const std::string& expr, size_t& pos);
+	// Outputs "1" for the accepting states and "0" for the others, then compresses the inputs.
+	void SetAcceptingOutputs(const std::vector<bool>& isAccepting);
 
-	NFAFragment ParseAtom(const std::string& expr, size_t& pos);
+	// Builds from a simplified tree, see RegularTree::Simplify.
+	NFAFragment BuildNFAFromTree(const RegularTree& tree, RegularTree::Id root);
 
-	NFAFragment GenerateNewStates(const Input& input);
+	// A fragment reading any of the inputs, epsilon when there are none.
+	NFAFragment GenerateNewStates(const std::vector<InputId>& inputs);
 
 	NFAFragment CreateAlternationNFA(const NFAFragment& a, const NFAFragment& b);
 
@@ -109,17 +198,32 @@ private:
 
 	NFAFragment CreateStarNFA(const NFAFragment& fragment);
 
+	NFAFragment CreatePlusNFA(const NFAFragment& fragment);
+
+	NFAFragment CreateOptionalNFA(const NFAFragment& fragment);
+
+	// The fragment, built on the states from firstState on, repeated min to max times.
+	NFAFragment CreateRepetitionNFA(const NFAFragment& fragment, StateId firstState, size_t min, size_t max);
+
+	// Copies the states firstState ... endState - 1 of a fragment nothing links to yet.
+	NFAFragment CopyFragment(const NFAFragment& fragment, StateId firstState, StateId endState);
+
+	// Adds the edges into a Glushkov position, one per input that enters it.
+	void AddPositionEdges(StateId from, StateId position);
+
 	State GenerateNewState();
 
-	static GrammarComponents ParseGrammarFile(std::ifstream& file);
+	static GrammarComponents ParseGrammarFile(std::string_view text);
 
 	static GrammarType DetectGrammarType(const GrammarComponents& grammar);
 
-	State m_initialState;
-	State m_currentState;
-	std::unordered_map<State, Output> m_stateOutputs;
-	TransitionMap m_transitions;
+	std::vector<OutputId> m_stateOutputs;
 	int m_stateCounter = 0;
+	RegularConstruction m_regularConstruction = RegularConstruction::THOMPSON;
+	// Glushkov positions indexed by state while a regular expression is built.
+	std::vector<GlushkovPosition> m_glushkovPositions;
+	// Set by FromRegularWithCounters, builds counted repetitions as one position each.
+	bool m_isCountingRepetitions = false;
 
 	static const State F_STATE;
 	static const State S_START;
@@ -0,0 +1,88 @@
+#include "RefinablePartition.h"
+
+#include <stdexcept>
+
+RefinablePartition::RefinablePartition(const size_t elementCount, const std::vector<std::vector<Id>>& sets)
+	: m_locations(elementCount)
+	, m_setOf(elementCount)
+{
+	m_elements.reserve(elementCount);
+	for (const auto& set : sets)
+	{
+		if (set.empty())
+		{
+			continue;
+		}
+		m_first.push_back(m_elements.size());
+		for (const auto element : set)
+		{
+			m_locations[element] = m_elements.size();
+			m_setOf[element] = m_first.size() - 1;
+			m_elements.push_back(element);
+		}
+		m_past.push_back(m_elements.size());
+	}
+	if (m_elements.size() != elementCount)
+	{
+		throw std::runtime_error("Initial sets do not cover all elements of the partition.");
+	}
+	m_marked.assign(m_first.size(), 0);
+}
+
+void RefinablePartition::Mark(const Id element)
+{
+	const auto set = m_setOf[element];
+	const auto location = m_locations[element];
+	const auto firstUnmarked = m_first[set] + m_marked[set];
+	if (location < firstUnmarked)
+	{
+		return;
+	}
+
+	m_elements[location] = m_elements[firstUnmarked];
+	m_locations[m_elements[location]] = location;
+	m_elements[firstUnmarked] = element;
+	m_locations[element] = firstUnmarked;
+
+	if (m_marked[set]++ == 0)
+	{
+		m_touched.push_back(set);
+	}
+}
+
+void RefinablePartition::Split()
+{
+	while (!m_touched.empty())
+	{
+		const auto set = m_touched.back();
+		m_touched.pop_back();
+
+		const auto firstUnmarked = m_first[set] + m_marked[set];
+		if (firstUnmarked == m_past[set])
+		{
+			m_marked[set] = 0;
+			continue;
+		}
+
+		const auto newSet = m_first.size();
+		if (m_marked[set] <= m_past[set] - firstUnmarked)
+		{
+			m_first.push_back(m_first[set]);
+			m_past.push_back(firstUnmarked);
+			m_first[set] = firstUnmarked;
+		}
+		else
+		{
+			m_first.push_back(firstUnmarked);
+			m_past.push_back(m_past[set]);
+			m_past[set] = firstUnmarked;
+		}
+		m_marked[set] = 0;
+		m_marked.push_back(0);
+
+		for (auto i = m_first[newSet]; i < m_past[newSet]; ++i)
+		{
+			m_setOf[m_elements[i]] = newSet;
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Partition of {0, ..., n - 1} that is refined by marking elements and then
+// splitting every touched set into its marked and unmarked parts. The smaller
+// part always becomes the new set, which is what Hopcroft style algorithms need.
+class RefinablePartition
+{
+public:
+	using Id = std::uint32_t;
+
+	// Every element must belong to exactly one of the sets, empty sets are skipped.
+	RefinablePartition(size_t elementCount, const std::vector<std::vector<Id>>& sets);
+
+	void Mark(Id element);
+
+	void Split();
+
+	size_t GetSetCount() const
+	{
+		return m_first.size();
+	}
+
+	size_t GetSetOf(const Id element) const
+	{
+		return m_setOf[element];
+	}
+
+	std::span<const Id> GetElements(const size_t set) const
+	{
+		return { m_elements.data() + m_first[set], m_past[set] - m_first[set] };
+	}
+
+private:
+	std::vector<Id> m_elements;
+	std::vector<size_t> m_locations;
+	std::vector<size_t> m_setOf;
+	std::vector<size_t> m_first;
+	std::vector<size_t> m_past;
+	std::vector<size_t> m_marked;
+	std::vector<size_t> m_touched;
+};
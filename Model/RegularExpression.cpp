@@ -0,0 +1,247 @@
+#include "RegularExpression.h"
+
+#include <algorithm>
+
+namespace
+{
+constexpr auto NO_ID = SymbolTable::NO_ID;
+} // namespace
+
+RegularExpression::RegularExpression()
+{
+	Intern(Kind::EMPTY, NO_ID, NO_ID, NO_ID, false);
+	Intern(Kind::EPSILON, NO_ID, NO_ID, NO_ID, true);
+}
+
+RegularExpression::Id RegularExpression::FromTree(
+	const RegularTree& tree, const RegularTree::Id root, const std::vector<Id>& byteClasses)
+{
+	// Shared subtrees of the tree are converted once.
+	std::unordered_map<RegularTree::Id, Id> terms;
+	const auto convert = [&](const auto& self, const RegularTree::Id subtree) -> Id {
+		if (const auto it = terms.find(subtree); it != terms.end())
+		{
+			return it->second;
+		}
+		const auto& node = tree.GetNode(subtree);
+		std::vector<Id> operands;
+		Id term = EPSILON;
+		switch (node.kind)
+		{
+		case RegularTree::Kind::EPSILON:
+			break;
+		case RegularTree::Kind::CLASS:
+			for (size_t byte = 0; byte < node.bytes.size(); ++byte)
+			{
+				if (node.bytes[byte])
+				{
+					operands.push_back(Symbol(byteClasses[byte]));
+				}
+			}
+			term = MakeAlternation(operands);
+			break;
+		case RegularTree::Kind::CONCATENATION:
+			// Joining from the right keeps each step constant, the terms are already right nested.
+			for (auto i = node.children.size(); i-- > 0;)
+			{
+				term = Concatenation(self(self, node.children[i]), term);
+			}
+			break;
+		case RegularTree::Kind::ALTERNATION:
+			for (const auto child : node.children)
+			{
+				AppendAlternatives(self(self, child), operands);
+			}
+			term = MakeAlternation(operands);
+			break;
+		case RegularTree::Kind::REPETITION:
+			term = Repeat(self(self, node.children.front()), node.min, node.max);
+			break;
+		}
+		terms.emplace(subtree, term);
+		return term;
+	};
+	return convert(convert, root);
+}
+
+RegularExpression::Id RegularExpression::Symbol(const Id input)
+{
+	return Intern(Kind::SYMBOL, input, NO_ID, NO_ID, false);
+}
+
+RegularExpression::Id RegularExpression::Concatenation(const Id left, const Id right)
+{
+	if (left == EMPTY || right == EMPTY)
+	{
+		return EMPTY;
+	}
+	if (left == EPSILON)
+	{
+		return right;
+	}
+	if (right == EPSILON)
+	{
+		return left;
+	}
+	const auto node = m_nodes[left];
+	if (node.kind == Kind::CONCATENATION)
+	{
+		return Concatenation(node.left, Concatenation(node.right, right));
+	}
+	return Intern(Kind::CONCATENATION, NO_ID, left, right, node.isNullable && m_nodes[right].isNullable);
+}
+
+RegularExpression::Id RegularExpression::Alternation(const Id left, const Id right)
+{
+	if (left == right || right == EMPTY)
+	{
+		return left;
+	}
+	if (left == EMPTY)
+	{
+		return right;
+	}
+	std::vector<Id> operands;
+	AppendAlternatives(left, operands);
+	AppendAlternatives(right, operands);
+	return MakeAlternation(operands);
+}
+
+RegularExpression::Id RegularExpression::Star(const Id term)
+{
+	if (term == EMPTY || term == EPSILON)
+	{
+		return EPSILON;
+	}
+	if (m_nodes[term].kind == Kind::STAR)
+	{
+		return term;
+	}
+	return Intern(Kind::STAR, NO_ID, term, NO_ID, true);
+}
+
+RegularExpression::Id RegularExpression::Repeat(const Id term, const size_t min, const size_t max)
+{
+	const auto isUnbounded = max == RegularTree::UNBOUNDED;
+	auto result = isUnbounded ? Star(term) : EPSILON;
+	for (auto count = min; !isUnbounded && count < max; ++count)
+	{
+		result = Alternation(EPSILON, Concatenation(term, result));
+	}
+	for (size_t count = 0; count < min; ++count)
+	{
+		result = Concatenation(term, result);
+	}
+	return result;
+}
+
+RegularExpression::Id RegularExpression::Derivative(const Id term, const Id input)
+{
+	const auto key = std::uint64_t{ term } << 32 | input;
+	if (const auto it = m_derivatives.find(key); it != m_derivatives.end())
+	{
+		return it->second;
+	}
+
+	// The node is copied, the recursion below may grow m_nodes.
+	const auto node = m_nodes[term];
+	Id derivative = EMPTY;
+	switch (node.kind)
+	{
+	case Kind::EMPTY:
+	case Kind::EPSILON:
+		break;
+	case Kind::SYMBOL:
+		derivative = node.input == input ? EPSILON : EMPTY;
+		break;
+	case Kind::CONCATENATION:
+		derivative = Concatenation(Derivative(node.left, input), node.right);
+		if (m_nodes[node.left].isNullable)
+		{
+			derivative = Alternation(derivative, Derivative(node.right, input));
+		}
+		break;
+	case Kind::ALTERNATION:
+	{
+		// One merge for the whole spine, merging pairwise would be quadratic in the operands.
+		std::vector<Id> alternatives;
+		AppendAlternatives(term, alternatives);
+		std::vector<Id> operands;
+		for (const auto alternative : alternatives)
+		{
+			AppendAlternatives(Derivative(alternative, input), operands);
+		}
+		derivative = MakeAlternation(operands);
+		break;
+	}
+	case Kind::STAR:
+		derivative = Concatenation(Derivative(node.left, input), term);
+		break;
+	}
+	m_derivatives.emplace(key, derivative);
+	return derivative;
+}
+
+size_t RegularExpression::NodeHash::operator()(const Node& node) const
+{
+	auto hash = static_cast<std::uint64_t>(node.kind);
+	for (const auto field : { node.input, node.left, node.right })
+	{
+		hash = (hash ^ field) * 0x9E3779B97F4A7C15ULL;
+	}
+	return static_cast<size_t>(hash ^ hash >> 32);
+}
+
+bool RegularExpression::NodeEqual::operator()(const Node& left, const Node& right) const
+{
+	return left.kind == right.kind && left.input == right.input && left.left == right.left && left.right == right.right;
+}
+
+RegularExpression::Id RegularExpression::Intern(const Kind kind, const Id input, const Id left, const Id right, const bool isNullable)
+{
+	const Node node{ kind, input, left, right, isNullable };
+	const auto [it, isNew] = m_ids.try_emplace(node, static_cast<Id>(m_nodes.size()));
+	if (isNew)
+	{
+		m_nodes.push_back(node);
+	}
+	return it->second;
+}
+
+RegularExpression::Id RegularExpression::MakeAlternation(std::vector<Id>& operands)
+{
+	std::ranges::sort(operands);
+	operands.erase(std::unique(operands.begin(), operands.end()), operands.end());
+	if (operands.size() > 1 && operands.front() == EMPTY)
+	{
+		operands.erase(operands.begin());
+	}
+	// Epsilon adds nothing next to another nullable operand.
+	const auto isOtherNullable = std::ranges::count_if(operands, [&](const Id operand) {
+		return m_nodes[operand].isNullable;
+	}) > 1;
+	if (isOtherNullable && operands.front() == EPSILON)
+	{
+		operands.erase(operands.begin());
+	}
+
+	// Operands are not alternations themselves, so the right spine lists them in order.
+	auto term = operands.back();
+	auto isNullable = m_nodes[term].isNullable;
+	for (auto i = operands.size() - 1; i-- > 0;)
+	{
+		isNullable = isNullable || m_nodes[operands[i]].isNullable;
+		term = Intern(Kind::ALTERNATION, NO_ID, operands[i], term, isNullable);
+	}
+	return term;
+}
+
+void RegularExpression::AppendAlternatives(Id term, std::vector<Id>& operands) const
+{
+	while (m_nodes[term].kind == Kind::ALTERNATION)
+	{
+		operands.push_back(m_nodes[term].left);
+		term = m_nodes[term].right;
+	}
+	operands.push_back(term);
+}
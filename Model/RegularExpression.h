@@ -0,0 +1,102 @@
+#pragma once
+
+#include "RegularTree.h"
+#include "SymbolTable.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Terms of regular expressions, hash-consed so that equal terms share one id
+// and comparing terms means comparing ids. The constructors keep every term
+// in a normal form: alternations are flattened, sorted and free of
+// duplicates, concatenations nest to the right and the empty and epsilon
+// terms are absorbed. That is enough to make the set of Brzozowski
+// derivatives of a term finite, so they can serve as DFA states directly.
+class RegularExpression
+{
+public:
+	using Id = SymbolTable::Id;
+
+	enum class Kind : std::uint8_t
+	{
+		EMPTY,
+		EPSILON,
+		SYMBOL,
+		CONCATENATION,
+		ALTERNATION,
+		STAR
+	};
+
+	struct Node
+	{
+		Kind kind;
+		// Input of a SYMBOL, NO_ID otherwise.
+		Id input;
+		Id left;
+		Id right;
+		bool isNullable;
+	};
+
+	// The term matching nothing and the term matching only the empty string.
+	static constexpr Id EMPTY = 0;
+	static constexpr Id EPSILON = 1;
+
+	RegularExpression();
+
+	// The term of a syntax tree, the inputs of its symbols are the byte classes of the bytes of
+	// its classes, see RegularTree::ClassifyBytes.
+	Id FromTree(const RegularTree& tree, RegularTree::Id root, const std::vector<Id>& byteClasses);
+
+	Id Symbol(Id input);
+
+	Id Concatenation(Id left, Id right);
+
+	Id Alternation(Id left, Id right);
+
+	Id Star(Id term);
+
+	// The term repeated min to max times, the optional copies nest as in (r(r)?)?.
+	Id Repeat(Id term, size_t min, size_t max);
+
+	// The term matching every w for which input w is matched by the given term.
+	Id Derivative(Id term, Id input);
+
+	const Node& GetNode(const Id term) const
+	{
+		return m_nodes[term];
+	}
+
+	bool IsNullable(const Id term) const
+	{
+		return m_nodes[term].isNullable;
+	}
+
+	size_t GetTermCount() const
+	{
+		return m_nodes.size();
+	}
+
+private:
+	struct NodeHash
+	{
+		size_t operator()(const Node& node) const;
+	};
+
+	struct NodeEqual
+	{
+		bool operator()(const Node& left, const Node& right) const;
+	};
+
+	Id Intern(Kind kind, Id input, Id left, Id right, bool isNullable);
+
+	// Builds the alternation of the operands, which are sorted and deduplicated in place.
+	Id MakeAlternation(std::vector<Id>& operands);
+
+	void AppendAlternatives(Id term, std::vector<Id>& operands) const;
+
+	std::vector<Node> m_nodes;
+	std::unordered_map<Node, Id, NodeHash, NodeEqual> m_ids;
+	// Derivatives already taken, keyed by term << 32 | input.
+	std::unordered_map<std::uint64_t, Id> m_derivatives;
+};
@@ -0,0 +1,587 @@
+#include "RegularTree.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace
+{
+constexpr auto NO_ID = SymbolTable::NO_ID;
+constexpr size_t BYTE_COUNT = 256;
+// Largest bound ParseRepetition reads, merged bounds stay within it too.
+constexpr size_t MAX_BOUND = UINT32_MAX;
+
+bool IsPostfix(const char c)
+{
+	return c == '*' || c == '+' || c == '?' || c == '{';
+}
+
+// Reads one character with pos on it, or on the '\\' escaping it, and leaves pos after it.
+unsigned char ReadCharacter(const std::string_view regular, size_t& pos)
+{
+	if (regular[pos] == '\\' && ++pos == regular.length())
+	{
+		throw std::runtime_error("Nothing to escape at the end of the expression");
+	}
+	return static_cast<unsigned char>(regular[pos++]);
+}
+
+size_t ReadNumber(const std::string_view regular, size_t& pos)
+{
+	const auto begin = pos;
+	size_t number = 0;
+	while (pos < regular.length() && regular[pos] >= '0' && regular[pos] <= '9')
+	{
+		number = number * 10 + static_cast<size_t>(regular[pos++] - '0');
+		if (number > MAX_BOUND)
+		{
+			throw std::runtime_error("Repetition count too large");
+		}
+	}
+	if (pos == begin)
+	{
+		throw std::runtime_error("Expected a number at position " + std::to_string(pos));
+	}
+	return number;
+}
+
+// Reads a class such as "[a-z0-9_]" with pos on the '[' and leaves pos after the ']'.
+RegularTree::ByteSet ParseClass(const std::string_view regular, size_t& pos)
+{
+	RegularTree::ByteSet bytes;
+	const auto begin = pos++;
+	while (pos < regular.length() && regular[pos] != ']')
+	{
+		const auto first = ReadCharacter(regular, pos);
+		auto last = first;
+		if (pos + 1 < regular.length() && regular[pos] == '-' && regular[pos + 1] != ']')
+		{
+			last = ReadCharacter(regular, ++pos);
+			if (last < first)
+			{
+				throw std::runtime_error("Reversed range in class at position " + std::to_string(begin));
+			}
+		}
+		for (auto byte = static_cast<size_t>(first); byte <= last; ++byte)
+		{
+			bytes.set(byte);
+		}
+	}
+	if (pos == regular.length())
+	{
+		throw std::runtime_error("Unclosed class at position " + std::to_string(begin));
+	}
+	if (bytes.none())
+	{
+		throw std::runtime_error("Empty class at position " + std::to_string(begin));
+	}
+	pos++;
+	return bytes;
+}
+
+// Reads "{n}", "{n,}" or "{n,m}" with pos on the '{' and leaves pos after the '}', returns the bounds.
+std::pair<size_t, size_t> ParseRepetition(const std::string_view regular, size_t& pos)
+{
+	const auto begin = pos++;
+	const auto min = ReadNumber(regular, pos);
+	auto max = min;
+	if (pos < regular.length() && regular[pos] == ',')
+	{
+		pos++;
+		max = pos < regular.length() && regular[pos] == '}' ? RegularTree::UNBOUNDED : ReadNumber(regular, pos);
+	}
+	if (pos == regular.length() || regular[pos] != '}')
+	{
+		throw std::runtime_error("Unclosed repetition at position " + std::to_string(begin));
+	}
+	if (max < min)
+	{
+		throw std::runtime_error("Repetition maximum below its minimum at position " + std::to_string(begin));
+	}
+	pos++;
+	return { min, max };
+}
+
+// Whether (r{min,max}){outerMin,outerMax} is r{min * outerMin, max * outerMax}, that is whether
+// the counts k * min ... k * max for k from outerMin to outerMax leave no gap.
+bool CanMultiply(const size_t min, const size_t max, const size_t outerMin, const size_t outerMax)
+{
+	if (outerMin == 0 && min > 1)
+	{
+		return false;
+	}
+	if (min * outerMin > MAX_BOUND
+		|| (max != RegularTree::UNBOUNDED && outerMax != RegularTree::UNBOUNDED && max * outerMax > MAX_BOUND))
+	{
+		return false;
+	}
+	if (outerMin == outerMax || max == RegularTree::UNBOUNDED)
+	{
+		return true;
+	}
+	// The gap between k and k + 1 copies only shrinks as k grows.
+	return std::max<size_t>(outerMin, 1) * (max - min) + 1 >= min;
+}
+} // namespace
+
+RegularTree::RegularTree()
+{
+	Intern(Kind::EPSILON, {}, {}, 0, 0);
+}
+
+RegularTree::Id RegularTree::Parse(const std::string_view regular)
+{
+	// Escaped spaces are kept with their '\\', the parser reads them as characters.
+	std::string expr;
+	for (size_t i = 0; i < regular.length(); ++i)
+	{
+		if (regular[i] == '\\' && i + 1 < regular.length())
+		{
+			expr += regular[i++];
+			expr += regular[i];
+		}
+		else if (regular[i] != ' ')
+		{
+			expr += regular[i];
+		}
+	}
+	if (expr.empty())
+	{
+		return EPSILON;
+	}
+
+	size_t pos = 0;
+	const auto tree = ParseAlternation(expr, pos);
+	if (pos != expr.length())
+	{
+		throw std::runtime_error("Unmatched closing parenthesis");
+	}
+	return tree;
+}
+
+RegularTree::Id RegularTree::Simplify(const Id tree)
+{
+	if (const auto it = m_simplified.find(tree); it != m_simplified.end())
+	{
+		return it->second;
+	}
+
+	// The node is copied, simplifying the children may grow m_nodes.
+	const auto node = m_nodes[tree];
+	std::vector<Id> children;
+	for (const auto child : node.children)
+	{
+		children.push_back(Simplify(child));
+	}
+	Id simplified = tree;
+	switch (node.kind)
+	{
+	case Kind::EPSILON:
+	case Kind::CLASS:
+		break;
+	case Kind::CONCATENATION:
+		simplified = Concatenation(children);
+		break;
+	case Kind::ALTERNATION:
+		simplified = Alternation(children);
+		break;
+	case Kind::REPETITION:
+		simplified = Repetition(children.front(), node.min, node.max);
+		break;
+	}
+	m_simplified.emplace(tree, simplified);
+	m_simplified.emplace(simplified, simplified);
+	return simplified;
+}
+
+std::vector<RegularTree::Id> RegularTree::ClassifyBytes(const std::span<const Id> trees) const
+{
+	// Every class splits the byte classes it cuts, the bytes inside get a class of their own.
+	std::vector<Id> classes(BYTE_COUNT, NO_ID);
+	Id classCount = 0;
+	std::vector<Id> split;
+	const auto refine = [&](const ByteSet& bytes) {
+		// New class of the bytes inside the set per old class, the last slot is for unread bytes.
+		const auto unread = classCount;
+		split.assign(unread + 1, NO_ID);
+		for (size_t byte = 0; byte < BYTE_COUNT; ++byte)
+		{
+			if (bytes[byte])
+			{
+				const auto old = classes[byte] == NO_ID ? unread : classes[byte];
+				if (split[old] == NO_ID)
+				{
+					split[old] = classCount++;
+				}
+				classes[byte] = split[old];
+			}
+		}
+	};
+
+	// Shared subtrees are visited once, the result does not depend on the order of the classes.
+	std::vector<char> isVisited(m_nodes.size(), 0);
+	std::vector<Id> pending(trees.begin(), trees.end());
+	while (!pending.empty())
+	{
+		const auto tree = pending.back();
+		pending.pop_back();
+		if (isVisited[tree])
+		{
+			continue;
+		}
+		isVisited[tree] = 1;
+		const auto& node = m_nodes[tree];
+		if (node.kind == Kind::CLASS)
+		{
+			refine(node.bytes);
+		}
+		pending.insert(pending.end(), node.children.begin(), node.children.end());
+	}
+
+	// Dense ids in the order of the smallest byte of each class.
+	std::vector<Id> dense(classCount, NO_ID);
+	Id denseCount = 0;
+	for (auto& byteClass : classes)
+	{
+		if (byteClass != NO_ID)
+		{
+			if (dense[byteClass] == NO_ID)
+			{
+				dense[byteClass] = denseCount++;
+			}
+			byteClass = dense[byteClass];
+		}
+	}
+	return classes;
+}
+
+size_t RegularTree::NodeHash::operator()(const Node& node) const
+{
+	auto hash = static_cast<std::uint64_t>(node.kind) ^ std::hash<ByteSet>{}(node.bytes);
+	for (const auto child : node.children)
+	{
+		hash = (hash ^ child) * 0x9E3779B97F4A7C15ULL;
+	}
+	hash = (hash ^ node.min) * 0x9E3779B97F4A7C15ULL;
+	hash = (hash ^ node.max) * 0x9E3779B97F4A7C15ULL;
+	return static_cast<size_t>(hash ^ hash >> 32);
+}
+
+bool RegularTree::NodeEqual::operator()(const Node& left, const Node& right) const
+{
+	return left.kind == right.kind && left.bytes == right.bytes && left.children == right.children
+		&& left.min == right.min && left.max == right.max;
+}
+
+RegularTree::Id RegularTree::Intern(
+	const Kind kind, const ByteSet& bytes, std::vector<Id> children, const size_t min, const size_t max)
+{
+	const auto isNullable = [&] {
+		switch (kind)
+		{
+		case Kind::EPSILON:
+			return true;
+		case Kind::CLASS:
+			return false;
+		case Kind::CONCATENATION:
+			return std::ranges::all_of(children, [this](const Id child) {
+				return m_nodes[child].isNullable;
+			});
+		case Kind::ALTERNATION:
+			return std::ranges::any_of(children, [this](const Id child) {
+				return m_nodes[child].isNullable;
+			});
+		case Kind::REPETITION:
+			return min == 0 || m_nodes[children.front()].isNullable;
+		}
+		return false;
+	}();
+
+	size_t nodeCount = 1;
+	for (const auto child : children)
+	{
+		nodeCount = std::min(nodeCount + m_nodes[child].nodeCount, SIZE_MAX / 2);
+	}
+
+	Node node{ kind, bytes, std::move(children), min, max, isNullable, nodeCount };
+	const auto [it, isNew] = m_ids.try_emplace(node, static_cast<Id>(m_nodes.size()));
+	if (isNew)
+	{
+		m_nodes.push_back(std::move(node));
+	}
+	return it->second;
+}
+
+RegularTree::Id RegularTree::Class(const ByteSet& bytes)
+{
+	return Intern(Kind::CLASS, bytes, {}, 0, 0);
+}
+
+RegularTree::Id RegularTree::Concatenation(const std::vector<Id>& operands)
+{
+	std::vector<Id> flat;
+	for (const auto operand : operands)
+	{
+		if (m_nodes[operand].kind == Kind::CONCATENATION)
+		{
+			const auto& children = m_nodes[operand].children;
+			flat.insert(flat.end(), children.begin(), children.end());
+		}
+		else if (operand != EPSILON)
+		{
+			flat.push_back(operand);
+		}
+	}
+
+	// Adjacent repetitions of one tree add up, r{a,b}r{c,d} is r{a+c,b+d}, so "a*a*" is "a*"
+	// and "aa*" is "a+". Plain trees count as r{1,1} but two of them stay as they are.
+	std::vector<Id> merged;
+	for (const auto operand : flat)
+	{
+		if (!merged.empty())
+		{
+			const auto& last = m_nodes[merged.back()];
+			const auto& next = m_nodes[operand];
+			const auto isLastRepeated = last.kind == Kind::REPETITION;
+			const auto isNextRepeated = next.kind == Kind::REPETITION;
+			const auto lastTree = isLastRepeated ? last.children.front() : merged.back();
+			const auto nextTree = isNextRepeated ? next.children.front() : operand;
+			const auto lastMin = isLastRepeated ? last.min : 1;
+			const auto lastMax = isLastRepeated ? last.max : 1;
+			const auto nextMin = isNextRepeated ? next.min : 1;
+			const auto nextMax = isNextRepeated ? next.max : 1;
+			const auto isUnbounded = lastMax == UNBOUNDED || nextMax == UNBOUNDED;
+			if ((isLastRepeated || isNextRepeated) && lastTree == nextTree && lastMin + nextMin <= MAX_BOUND
+				&& (isUnbounded || lastMax + nextMax <= MAX_BOUND))
+			{
+				merged.back() = Repetition(lastTree, lastMin + nextMin, isUnbounded ? UNBOUNDED : lastMax + nextMax);
+				continue;
+			}
+		}
+		merged.push_back(operand);
+	}
+
+	if (merged.empty())
+	{
+		return EPSILON;
+	}
+	return merged.size() == 1 ? merged.front() : Intern(Kind::CONCATENATION, {}, std::move(merged), 0, 0);
+}
+
+RegularTree::Id RegularTree::Alternation(const std::vector<Id>& operands)
+{
+	// Alternatives are grouped by the tree they start with, in the order of their first occurrence.
+	std::vector<Id> firsts;
+	std::unordered_map<Id, std::vector<Id>> groups;
+	const auto add = [&](const Id alternative) {
+		const auto& node = m_nodes[alternative];
+		const auto first = node.kind == Kind::CONCATENATION ? node.children.front() : alternative;
+		auto& group = groups[first];
+		if (group.empty())
+		{
+			firsts.push_back(first);
+		}
+		if (std::ranges::find(group, alternative) == group.end())
+		{
+			group.push_back(alternative);
+		}
+	};
+	for (const auto operand : operands)
+	{
+		if (m_nodes[operand].kind == Kind::ALTERNATION)
+		{
+			for (const auto child : m_nodes[operand].children)
+			{
+				add(child);
+			}
+		}
+		else
+		{
+			add(operand);
+		}
+	}
+
+	// Common prefixes are factored out, "abc|abd" is "ab(c|d)". Characters and classes merge into
+	// one class, and epsilon goes unless nothing else is nullable, then it makes the rest optional.
+	std::vector<Id> alternatives;
+	ByteSet bytes;
+	size_t classIndex = SIZE_MAX;
+	bool hasEpsilon = false;
+	for (const auto first : firsts)
+	{
+		auto members = groups[first];
+		if (members.size() > 1)
+		{
+			std::vector<Id> rests;
+			size_t memberCount = 0;
+			for (const auto member : members)
+			{
+				const auto children = m_nodes[member].children;
+				rests.push_back(member == first ? EPSILON : Concatenation({ children.begin() + 1, children.end() }));
+				memberCount += m_nodes[member].nodeCount;
+			}
+			// A short prefix shared by few alternatives may save fewer nodes than factoring adds.
+			const auto factored = Concatenation({ first, Alternation(rests) });
+			if (m_nodes[factored].nodeCount < memberCount)
+			{
+				members = { factored };
+			}
+		}
+
+		for (const auto alternative : members)
+		{
+			if (alternative == EPSILON)
+			{
+				hasEpsilon = true;
+			}
+			else if (m_nodes[alternative].kind == Kind::CLASS)
+			{
+				bytes |= m_nodes[alternative].bytes;
+				if (classIndex == SIZE_MAX)
+				{
+					classIndex = alternatives.size();
+					alternatives.push_back(alternative);
+				}
+			}
+			else
+			{
+				alternatives.push_back(alternative);
+			}
+		}
+	}
+	if (classIndex != SIZE_MAX)
+	{
+		alternatives[classIndex] = Class(bytes);
+	}
+
+	if (alternatives.empty())
+	{
+		return EPSILON;
+	}
+	const auto tree = alternatives.size() == 1 ? alternatives.front() : Intern(Kind::ALTERNATION, {}, std::move(alternatives), 0, 0);
+	return hasEpsilon && !m_nodes[tree].isNullable ? Repetition(tree, 0, 1) : tree;
+}
+
+RegularTree::Id RegularTree::Repetition(const Id tree, size_t min, const size_t max)
+{
+	if (max == 0 || tree == EPSILON)
+	{
+		return EPSILON;
+	}
+	// The node is copied, the rewrites below may grow m_nodes.
+	const auto node = m_nodes[tree];
+	// Fewer copies of a nullable tree match within more copies, so the minimum adds nothing.
+	if (node.isNullable)
+	{
+		min = 0;
+	}
+	if (min == 1 && max == 1)
+	{
+		return tree;
+	}
+
+	if (node.kind == Kind::REPETITION && CanMultiply(node.min, node.max, min, max))
+	{
+		const auto isUnbounded = node.max == UNBOUNDED || max == UNBOUNDED;
+		return Repetition(node.children.front(), node.min * min, isUnbounded ? UNBOUNDED : node.max * max);
+	}
+
+	// Under a star the alternatives repeat on their own, "(a*|b+)*" is "(a|b)*".
+	if (node.kind == Kind::ALTERNATION && min == 0 && max == UNBOUNDED)
+	{
+		std::vector<Id> alternatives;
+		bool isChanged = false;
+		for (const auto child : node.children)
+		{
+			const auto& childNode = m_nodes[child];
+			const auto isStarred = childNode.kind == Kind::REPETITION && childNode.min <= 1;
+			alternatives.push_back(isStarred ? childNode.children.front() : child);
+			isChanged = isChanged || isStarred;
+		}
+		if (isChanged)
+		{
+			return Repetition(Alternation(alternatives), 0, UNBOUNDED);
+		}
+	}
+	return Intern(Kind::REPETITION, {}, { tree }, min, max);
+}
+
+RegularTree::Id RegularTree::ParseAlternation(const std::string_view regular, size_t& pos)
+{
+	std::vector<Id> operands = { ParseConcatenation(regular, pos) };
+	while (pos < regular.length() && regular[pos] == '|')
+	{
+		pos++;
+		operands.push_back(ParseConcatenation(regular, pos));
+	}
+	return operands.size() == 1 ? operands.front() : Intern(Kind::ALTERNATION, {}, std::move(operands), 0, 0);
+}
+
+RegularTree::Id RegularTree::ParseConcatenation(const std::string_view regular, size_t& pos)
+{
+	std::vector<Id> operands;
+	while (pos < regular.length() && regular[pos] != ')' && regular[pos] != '|')
+	{
+		operands.push_back(ParseElement(regular, pos));
+	}
+	// An empty alternative, as in "(|a)" or "()", is epsilon.
+	if (operands.empty())
+	{
+		return EPSILON;
+	}
+	return operands.size() == 1 ? operands.front() : Intern(Kind::CONCATENATION, {}, std::move(operands), 0, 0);
+}
+
+RegularTree::Id RegularTree::ParseElement(const std::string_view regular, size_t& pos)
+{
+	auto tree = ParseAtom(regular, pos);
+	while (pos < regular.length() && IsPostfix(regular[pos]))
+	{
+		if (regular[pos] == '{')
+		{
+			const auto [min, max] = ParseRepetition(regular, pos);
+			tree = Intern(Kind::REPETITION, {}, { tree }, min, max);
+			continue;
+		}
+		const auto c = regular[pos++];
+		tree = Intern(Kind::REPETITION, {}, { tree }, c == '+' ? 1 : 0, c == '?' ? 1 : UNBOUNDED);
+	}
+	return tree;
+}
+
+RegularTree::Id RegularTree::ParseAtom(const std::string_view regular, size_t& pos)
+{
+	if (pos >= regular.length())
+	{
+		throw std::runtime_error("Unexpected end of expression");
+	}
+
+	if (regular[pos] == '[')
+	{
+		return Class(ParseClass(regular, pos));
+	}
+
+	if (regular[pos] == '\\')
+	{
+		return Class(ByteSet().set(ReadCharacter(regular, pos)));
+	}
+
+	const auto c = regular[pos++];
+	if (c == '(')
+	{
+		const auto tree = ParseAlternation(regular, pos);
+		if (pos >= regular.length() || regular[pos] != ')')
+		{
+			throw std::runtime_error("Expected closing parenthesis");
+		}
+		pos++;
+		return tree;
+	}
+	if (c == ')' || c == '|' || IsPostfix(c))
+	{
+		throw std::runtime_error("Unexpected '" + std::string(1, c) + "' at position " + std::to_string(pos - 1));
+	}
+	return Class(ByteSet().set(static_cast<unsigned char>(c)));
+}
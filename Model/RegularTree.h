@@ -0,0 +1,111 @@
+#pragma once
+
+#include "SymbolTable.h"
+
+#include <bitset>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Syntax trees of regular expressions as MooreMachine::FromRegular reads them,
+// hash-consed like RegularExpression terms but without its normal forms, and
+// with repetitions kept as single nodes instead of unrolled. Parse is the one
+// parser of the expression syntax, every construction starts from its tree,
+// RegularExpression and CountingAutomaton included. Parse keeps the
+// tree as written; Simplify rewrites it bottom-up into an equivalent tree that
+// is never larger: alternatives are deduplicated, characters and classes among
+// them merged into one class and common prefixes factored out where that pays,
+// epsilon goes away wherever it adds nothing, and nested or adjacent
+// repetitions of one tree merge, so "(a*)*", "(|a)*" and "a*a*" become "a*".
+class RegularTree
+{
+public:
+	using Id = SymbolTable::Id;
+	using ByteSet = std::bitset<256>;
+
+	static constexpr size_t UNBOUNDED = SIZE_MAX;
+
+	enum class Kind : std::uint8_t
+	{
+		EPSILON,
+		CLASS,
+		CONCATENATION,
+		ALTERNATION,
+		REPETITION
+	};
+
+	struct Node
+	{
+		Kind kind;
+		// Bytes of a CLASS, a single character is a class of one byte.
+		ByteSet bytes;
+		// Operands of a CONCATENATION or ALTERNATION, the repeated tree of a REPETITION.
+		std::vector<Id> children;
+		// Bounds of a REPETITION, "*" is 0 to UNBOUNDED, "+" 1 to UNBOUNDED and "?" 0 to 1.
+		size_t min;
+		size_t max;
+		bool isNullable;
+		// Nodes of the tree with shared subtrees counted once per occurrence.
+		size_t nodeCount;
+	};
+
+	static constexpr Id EPSILON = 0;
+
+	RegularTree();
+
+	// Parses the syntax of MooreMachine::FromRegular without rewriting anything, unescaped spaces
+	// are ignored.
+	Id Parse(std::string_view regular);
+
+	Id Simplify(Id tree);
+
+	// Splits the bytes read by the classes of the trees into the fewest classes that none of them
+	// tells apart, numbered by their smallest byte. classes[byte] is NO_ID for bytes never read.
+	std::vector<Id> ClassifyBytes(std::span<const Id> trees) const;
+
+	size_t GetNodeCount(const Id tree) const
+	{
+		return m_nodes[tree].nodeCount;
+	}
+
+	const Node& GetNode(const Id tree) const
+	{
+		return m_nodes[tree];
+	}
+
+private:
+	struct NodeHash
+	{
+		size_t operator()(const Node& node) const;
+	};
+
+	struct NodeEqual
+	{
+		bool operator()(const Node& left, const Node& right) const;
+	};
+
+	Id Intern(Kind kind, const ByteSet& bytes, std::vector<Id> children, size_t min, size_t max);
+
+	Id Class(const ByteSet& bytes);
+
+	// The rewriting constructors, the operands must be simplified already.
+	Id Concatenation(const std::vector<Id>& operands);
+
+	Id Alternation(const std::vector<Id>& operands);
+
+	Id Repetition(Id tree, size_t min, size_t max);
+
+	Id ParseAlternation(std::string_view regular, size_t& pos);
+
+	Id ParseConcatenation(std::string_view regular, size_t& pos);
+
+	Id ParseElement(std::string_view regular, size_t& pos);
+
+	Id ParseAtom(std::string_view regular, size_t& pos);
+
+	std::vector<Node> m_nodes;
+	std::unordered_map<Node, Id, NodeHash, NodeEqual> m_ids;
+	std::unordered_map<Id, Id> m_simplified;
+};
@@ -0,0 +1,242 @@
+#include "RequiredInputs.h"
+
+#include <algorithm>
+
+namespace
+{
+constexpr auto NO_ID = TransitionTable::NO_ID;
+
+struct InEdge
+{
+	TransitionTable::Id input;
+	TransitionTable::Id from;
+};
+} // namespace
+
+RequiredInputs::RequiredInputs(const TransitionTable& table, const std::span<const char> accepting)
+{
+	const auto stateCount = table.GetStateCount();
+	const auto inputCount = table.GetInputCount();
+	const auto start = table.GetInitialState();
+	if (start >= stateCount || accepting[start])
+	{
+		return;
+	}
+
+	// Useful states are reachable from the start and can still reach an accepting state.
+	std::vector<std::vector<InEdge>> inEdges(stateCount);
+	std::vector<char> isReachable(stateCount, 0);
+	std::vector<Id> order = { start };
+	isReachable[start] = 1;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		for (Id input = 0; input < inputCount; ++input)
+		{
+			const auto to = table.GetNextState(order[i], input);
+			if (to == NO_ID)
+			{
+				continue;
+			}
+			inEdges[to].push_back({ input, order[i] });
+			if (!isReachable[to])
+			{
+				isReachable[to] = 1;
+				order.push_back(to);
+			}
+		}
+	}
+	std::vector<char> isUseful(stateCount, 0);
+	std::vector<Id> queue;
+	for (const auto state : order)
+	{
+		if (accepting[state])
+		{
+			isUseful[state] = 1;
+			queue.push_back(state);
+		}
+	}
+	for (size_t i = 0; i < queue.size(); ++i)
+	{
+		for (const auto& edge : inEdges[queue[i]])
+		{
+			if (!isUseful[edge.from])
+			{
+				isUseful[edge.from] = 1;
+				queue.push_back(edge.from);
+			}
+		}
+	}
+	if (!isUseful[start])
+	{
+		return;
+	}
+
+	for (Id input = 0; input < inputCount; ++input)
+	{
+		const auto to = table.GetNextState(start, input);
+		if (to != NO_ID && isUseful[to])
+		{
+			m_firstInputs.push_back(input);
+		}
+	}
+
+	// Dominators over the useful states plus a sink every accepting state leads to, with the
+	// iterative algorithm of Cooper, Harvey and Kennedy on a reverse post order.
+	const auto sink = static_cast<Id>(stateCount);
+	std::vector<size_t> postIndex(stateCount + 1, NO_ID);
+	std::vector<Id> postOrder;
+	std::vector<std::pair<Id, Id>> stack = { { start, 0 } };
+	postIndex[start] = 0;
+	while (!stack.empty())
+	{
+		auto& [state, input] = stack.back();
+		if (state == sink || input == inputCount)
+		{
+			if (state != sink && accepting[state] && postIndex[sink] == NO_ID)
+			{
+				postIndex[sink] = 0;
+				stack.push_back({ sink, 0 });
+				continue;
+			}
+			postIndex[state] = postOrder.size();
+			postOrder.push_back(state);
+			stack.pop_back();
+			continue;
+		}
+		const auto to = table.GetNextState(state, input++);
+		if (to != NO_ID && isUseful[to] && postIndex[to] == NO_ID)
+		{
+			postIndex[to] = 0;
+			stack.push_back({ to, 0 });
+		}
+	}
+
+	const auto forEachPredecessor = [&](const Id state, const auto& onPredecessor) {
+		if (state == sink)
+		{
+			for (const auto from : postOrder)
+			{
+				if (from != sink && accepting[from])
+				{
+					onPredecessor(from);
+				}
+			}
+			return;
+		}
+		for (const auto& edge : inEdges[state])
+		{
+			if (isUseful[edge.from])
+			{
+				onPredecessor(edge.from);
+			}
+		}
+	};
+
+	std::vector<Id> dominators(stateCount + 1, NO_ID);
+	dominators[start] = start;
+	const auto intersect = [&](Id left, Id right) {
+		while (left != right)
+		{
+			while (postIndex[left] < postIndex[right])
+			{
+				left = dominators[left];
+			}
+			while (postIndex[right] < postIndex[left])
+			{
+				right = dominators[right];
+			}
+		}
+		return left;
+	};
+	for (bool isChanged = true; isChanged;)
+	{
+		isChanged = false;
+		for (auto it = postOrder.rbegin(); it != postOrder.rend(); ++it)
+		{
+			const auto state = *it;
+			if (state == start)
+			{
+				continue;
+			}
+			auto dominator = NO_ID;
+			forEachPredecessor(state, [&](const Id from) {
+				if (dominators[from] != NO_ID)
+				{
+					dominator = dominator == NO_ID ? from : intersect(from, dominator);
+				}
+			});
+			if (dominators[state] != dominator)
+			{
+				dominators[state] = dominator;
+				isChanged = true;
+			}
+		}
+	}
+
+	const auto usefulSuccessor = [&](const Id state, Id& input) {
+		auto next = NO_ID;
+		for (Id candidate = 0; candidate < inputCount; ++candidate)
+		{
+			const auto to = table.GetNextState(state, candidate);
+			if (to != NO_ID && isUseful[to])
+			{
+				if (next != NO_ID)
+				{
+					return NO_ID;
+				}
+				next = to;
+				input = candidate;
+			}
+		}
+		return next;
+	};
+
+	for (auto required = dominators[sink]; required != NO_ID; required = required == start ? NO_ID : dominators[required])
+	{
+		std::vector<Id> literal;
+		auto state = required;
+		for (size_t step = 0; step < stateCount && state != start; ++step)
+		{
+			const auto& edges = inEdges[state];
+			const auto& first = *std::find_if(edges.begin(), edges.end(), [&](const InEdge& edge) {
+				return isUseful[edge.from];
+			});
+			const auto input = first.input;
+			const auto from = first.from;
+			const auto isSameInput = std::all_of(edges.begin(), edges.end(), [&](const InEdge& edge) {
+				return !isUseful[edge.from] || edge.input == input;
+			});
+			if (!isSameInput)
+			{
+				break;
+			}
+			literal.push_back(input);
+			const auto isSamePredecessor = std::all_of(edges.begin(), edges.end(), [&](const InEdge& edge) {
+				return !isUseful[edge.from] || edge.from == from;
+			});
+			if (!isSamePredecessor)
+			{
+				break;
+			}
+			state = from;
+		}
+		std::reverse(literal.begin(), literal.end());
+
+		state = required;
+		for (size_t step = 0; step < stateCount && !accepting[state]; ++step)
+		{
+			Id input = NO_ID;
+			state = usefulSuccessor(state, input);
+			if (state == NO_ID)
+			{
+				break;
+			}
+			literal.push_back(input);
+		}
+
+		if (literal.size() > m_literal.size())
+		{
+			m_literal = std::move(literal);
+		}
+	}
+}
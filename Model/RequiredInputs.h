@@ -0,0 +1,36 @@
+#pragma once
+
+#include "TransitionTable.h"
+
+#include <span>
+#include <vector>
+
+// Inputs that every sequence a deterministic machine accepts must contain, so a
+// search can skip to them before running the machine. States every accepting
+// path passes through are found as dominators of the accepting states. Around
+// each of them the path is forced while a state has a single useful way out
+// forwards, or a single input and predecessor leading into it backwards.
+class RequiredInputs
+{
+public:
+	using Id = TransitionTable::Id;
+
+	// accepting[s] tells whether state s accepts.
+	RequiredInputs(const TransitionTable& table, std::span<const char> accepting);
+
+	// Longest found run of inputs every accepted sequence contains, empty when there is none.
+	const std::vector<Id>& GetLiteral() const
+	{
+		return m_literal;
+	}
+
+	// Inputs every accepted sequence starts with one of, empty when the empty sequence is accepted.
+	const std::vector<Id>& GetFirstInputs() const
+	{
+		return m_firstInputs;
+	}
+
+private:
+	std::vector<Id> m_literal;
+	std::vector<Id> m_firstInputs;
+};
@@ -0,0 +1,67 @@
+#include "StateSetTable.h"
+
+#include <algorithm>
+
+std::pair<StateSetTable::Id, bool> StateSetTable::Intern(const std::span<const Id> states)
+{
+	if ((Size() + 1) * 2 > m_slots.size())
+	{
+		Grow();
+	}
+
+	const auto hash = Hash(states);
+	const auto mask = m_slots.size() - 1;
+	auto slot = hash & mask;
+	while (m_slots[slot] != NO_ID)
+	{
+		const auto id = m_slots[slot];
+		if (m_hashes[id] == hash && std::ranges::equal(GetSet(id), states))
+		{
+			return { id, false };
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	const auto id = static_cast<Id>(Size());
+	m_pool.insert(m_pool.end(), states.begin(), states.end());
+	m_offsets.push_back(m_pool.size());
+	m_hashes.push_back(hash);
+	m_slots[slot] = id;
+	return { id, true };
+}
+
+void StateSetTable::Clear()
+{
+	m_pool.clear();
+	m_offsets.resize(1);
+	m_hashes.clear();
+	std::ranges::fill(m_slots, NO_ID);
+}
+
+std::uint64_t StateSetTable::Hash(const std::span<const Id> states)
+{
+	std::uint64_t hash = states.size();
+	for (const auto state : states)
+	{
+		hash = (hash ^ state) * 0x9E3779B97F4A7C15ULL;
+		hash ^= hash >> 32;
+	}
+	return hash;
+}
+
+void StateSetTable::Grow()
+{
+	const auto capacity = std::max<size_t>(16, m_slots.size() * 2);
+	m_slots.assign(capacity, NO_ID);
+
+	const auto mask = capacity - 1;
+	for (Id id = 0; id < Size(); ++id)
+	{
+		auto slot = m_hashes[id] & mask;
+		while (m_slots[slot] != NO_ID)
+		{
+			slot = (slot + 1) & mask;
+		}
+		m_slots[slot] = id;
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "SymbolTable.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Interns sorted sets of state ids for the subset construction. Sets are kept
+// back to back in one pool and found through an open addressing hash table,
+// so looking up a set costs one hash and usually one comparison.
+class StateSetTable
+{
+public:
+	using Id = SymbolTable::Id;
+
+	static constexpr Id NO_ID = SymbolTable::NO_ID;
+
+	// The set must be sorted and free of duplicates. Returns its id and whether it is new.
+	std::pair<Id, bool> Intern(std::span<const Id> states);
+
+	// Views into the pool are invalidated by the next Intern of a new set.
+	std::span<const Id> GetSet(const Id id) const
+	{
+		return { m_pool.data() + m_offsets[id], m_offsets[id + 1] - m_offsets[id] };
+	}
+
+	size_t Size() const
+	{
+		return m_hashes.size();
+	}
+
+	// Forgets all sets but keeps the memory for the next ones.
+	void Clear();
+
+private:
+	static std::uint64_t Hash(std::span<const Id> states);
+
+	void Grow();
+
+	std::vector<Id> m_pool;
+	std::vector<size_t> m_offsets = { 0 };
+	std::vector<std::uint64_t> m_hashes;
+	std::vector<Id> m_slots;
+};
+
+// Membership marks over state ids that are cleared in O(1) between uses.
+class StateMarker
+{
+public:
+	using Id = SymbolTable::Id;
+
+	explicit StateMarker(const size_t stateCount)
+		: m_stamps(stateCount, 0)
+	{
+	}
+
+	void Reset()
+	{
+		if (++m_stamp == 0)
+		{
+			std::ranges::fill(m_stamps, 0);
+			m_stamp = 1;
+		}
+	}
+
+	// Returns false when the state is already marked.
+	bool Insert(const Id state)
+	{
+		if (m_stamps[state] == m_stamp)
+		{
+			return false;
+		}
+		m_stamps[state] = m_stamp;
+		return true;
+	}
+
+private:
+	std::vector<std::uint32_t> m_stamps;
+	std::uint32_t m_stamp = 1;
+};
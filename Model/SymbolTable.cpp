@@ -0,0 +1,48 @@
+#include "SymbolTable.h"
+
+#include <stdexcept>
+
+SymbolTable::Id SymbolTable::Intern(const std::string_view name)
+{
+	const auto it = m_ids.find(name);
+	if (it != m_ids.end())
+	{
+		return it->second;
+	}
+	if (m_names.size() >= NO_ID - 1)
+	{
+		throw std::runtime_error("Symbol table overflow");
+	}
+
+	const auto id = static_cast<Id>(m_names.size());
+	m_names.emplace_back(name);
+	m_ids.emplace(m_names.back(), id);
+	return id;
+}
+
+SymbolTable::Id SymbolTable::Find(const std::string_view name) const
+{
+	const auto it = m_ids.find(name);
+	return it == m_ids.end() ? NO_ID : it->second;
+}
+
+void SymbolTable::Generate(const size_t count, const std::string_view prefix)
+{
+	Reserve(m_names.size() + count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		Intern(std::string(prefix) + std::to_string(i));
+	}
+}
+
+void SymbolTable::Reserve(const size_t count)
+{
+	m_names.reserve(count);
+	m_ids.reserve(count);
+}
+
+void SymbolTable::Clear()
+{
+	m_names.clear();
+	m_ids.clear();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Maps names of states, inputs and outputs to dense ids so that algorithms
+// can work with integers and only touch strings when loading or saving.
+class SymbolTable
+{
+public:
+	using Id = std::uint32_t;
+
+	static constexpr Id NO_ID = std::numeric_limits<Id>::max();
+
+	Id Intern(std::string_view name);
+
+	Id Find(std::string_view name) const;
+
+	// Appends "<prefix>0" ... "<prefix>(count - 1)" for machines built purely on ids.
+	void Generate(size_t count, std::string_view prefix);
+
+	void Reserve(size_t count);
+
+	void Clear();
+
+	bool Contains(std::string_view name) const
+	{
+		return Find(name) != NO_ID;
+	}
+
+	const std::string& GetName(const Id id) const
+	{
+		return m_names[id];
+	}
+
+	const std::vector<std::string>& GetNames() const
+	{
+		return m_names;
+	}
+
+	size_t Size() const
+	{
+		return m_names.size();
+	}
+
+	bool Empty() const
+	{
+		return m_names.empty();
+	}
+
+private:
+	struct Hash
+	{
+		using is_transparent = void;
+
+		size_t operator()(const std::string_view name) const
+		{
+			return std::hash<std::string_view>{}(name);
+		}
+	};
+
+	std::vector<std::string> m_names;
+	std::unordered_map<std::string, Id, Hash, std::equal_to<>> m_ids;
+};
@@ -0,0 +1,113 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(const size_t threadCount)
+{
+	const auto workerCount = ResolveThreadCount(threadCount) - 1;
+	m_workers.reserve(workerCount);
+	for (size_t i = 0; i < workerCount; ++i)
+	{
+		m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_isStopping = true;
+	}
+	m_hasWork.notify_all();
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+size_t ThreadPool::ResolveThreadCount(const size_t threadCount)
+{
+	if (threadCount != 0)
+	{
+		return threadCount;
+	}
+	return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::Run(const size_t taskCount, const std::function<void(size_t)>& task)
+{
+	if (taskCount == 0)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard lock(m_mutex);
+		m_task = &task;
+		m_taskCount = taskCount;
+		m_nextTask = 0;
+		m_error = nullptr;
+		++m_batch;
+	}
+	m_hasWork.notify_all();
+
+	RunTasks();
+
+	std::unique_lock lock(m_mutex);
+	m_isDone.wait(lock, [this] { return m_nextTask >= m_taskCount && m_busyWorkers == 0; });
+	m_task = nullptr;
+	if (m_error)
+	{
+		std::rethrow_exception(m_error);
+	}
+}
+
+void ThreadPool::WorkerLoop()
+{
+	size_t seenBatch = 0;
+	while (true)
+	{
+		{
+			std::unique_lock lock(m_mutex);
+			m_hasWork.wait(lock, [&] { return m_isStopping || m_batch != seenBatch; });
+			if (m_isStopping)
+			{
+				return;
+			}
+			seenBatch = m_batch;
+		}
+		RunTasks();
+	}
+}
+
+void ThreadPool::RunTasks()
+{
+	std::unique_lock lock(m_mutex);
+	++m_busyWorkers;
+	while (m_task && m_nextTask < m_taskCount)
+	{
+		const auto index = m_nextTask++;
+		const auto* task = m_task;
+		lock.unlock();
+		try
+		{
+			(*task)(index);
+		}
+		catch (...)
+		{
+			lock.lock();
+			if (!m_error)
+			{
+				m_error = std::current_exception();
+			}
+			m_nextTask = m_taskCount;
+			continue;
+		}
+		lock.lock();
+	}
+	--m_busyWorkers;
+	if (m_busyWorkers == 0)
+	{
+		m_isDone.notify_all();
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run batches of indexed tasks. The calling
+// thread takes part in every batch, so a pool of one thread runs inline.
+class ThreadPool
+{
+public:
+	// Zero means one thread per hardware core.
+	explicit ThreadPool(size_t threadCount);
+
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Runs task(0) ... task(taskCount - 1) and waits for all of them, rethrows the first failure.
+	void Run(size_t taskCount, const std::function<void(size_t)>& task);
+
+	size_t GetThreadCount() const
+	{
+		return m_workers.size() + 1;
+	}
+
+	static size_t ResolveThreadCount(size_t threadCount);
+
+private:
+	void WorkerLoop();
+
+	void RunTasks();
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_hasWork;
+	std::condition_variable m_isDone;
+	const std::function<void(size_t)>* m_task = nullptr;
+	size_t m_taskCount = 0;
+	size_t m_nextTask = 0;
+	size_t m_busyWorkers = 0;
+	size_t m_batch = 0;
+	bool m_isStopping = false;
+	std::exception_ptr m_error;
+};
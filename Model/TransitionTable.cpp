@@ -0,0 +1,162 @@
+#include "TransitionTable.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace
+{
+// Streams in flight at once, enough to cover the latency of a cache missing load.
+constexpr size_t STREAM_LANES = 16;
+} // namespace
+
+TransitionTable::TransitionTable(const size_t stateCount, const size_t inputCount)
+	: m_stateCount(stateCount)
+	, m_inputCount(inputCount)
+	, m_nextStates(stateCount * inputCount, NO_ID)
+{
+}
+
+void TransitionTable::SetNextState(const Id state, const Id input, const Id nextState)
+{
+	m_nextStates[state * m_inputCount + input] = nextState;
+}
+
+void TransitionTable::SetStateOutput(const Id state, const Id output)
+{
+	if (m_stateOutputs.empty())
+	{
+		m_stateOutputs.assign(m_stateCount, NO_ID);
+	}
+	m_stateOutputs[state] = output;
+}
+
+void TransitionTable::SetTransitionOutput(const Id state, const Id input, const Id output)
+{
+	if (m_transitionOutputs.empty())
+	{
+		m_transitionOutputs.assign(m_stateCount * m_inputCount, NO_ID);
+	}
+	m_transitionOutputs[state * m_inputCount + input] = output;
+}
+
+TransitionTable::RunResult TransitionTable::Run(Id state, const std::span<const Id> inputs, const std::span<Id> outputs) const
+{
+	if (!outputs.empty() && outputs.size() < inputs.size())
+	{
+		throw std::runtime_error("The output buffer is shorter than the input.");
+	}
+	if (state >= m_stateCount)
+	{
+		return { state, 0 };
+	}
+
+	const auto* nextStates = m_nextStates.data();
+	const auto inputCount = m_inputCount;
+	const bool writeStateOutputs = !outputs.empty() && HasStateOutputs();
+	const bool writeTransitionOutputs = !outputs.empty() && HasTransitionOutputs();
+
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		const auto input = inputs[i];
+		if (input >= inputCount)
+		{
+			return { state, i };
+		}
+		const auto index = state * inputCount + input;
+		const auto nextState = nextStates[index];
+		if (nextState == NO_ID)
+		{
+			return { state, i };
+		}
+
+		if (writeTransitionOutputs)
+		{
+			outputs[i] = m_transitionOutputs[index];
+		}
+		else if (writeStateOutputs)
+		{
+			outputs[i] = m_stateOutputs[nextState];
+		}
+		state = nextState;
+	}
+	return { state };
+}
+
+void TransitionTable::RunStreams(
+	const Id state,
+	const std::span<const std::span<const Id>> streams,
+	const std::span<RunResult> results) const
+{
+	if (results.size() < streams.size())
+	{
+		throw std::runtime_error("The result buffer is shorter than the list of streams.");
+	}
+	if (state >= m_stateCount)
+	{
+		std::fill_n(results.begin(), streams.size(), RunResult{ state, 0 });
+		return;
+	}
+
+	struct Lane
+	{
+		const Id* input;
+		const Id* end;
+		size_t stream;
+		Id state;
+	};
+
+	std::array<Lane, STREAM_LANES> lanes;
+	size_t laneCount = 0;
+	size_t nextStream = 0;
+
+	const auto startNextStream = [&](Lane& lane) {
+		for (; nextStream < streams.size(); ++nextStream)
+		{
+			const auto stream = streams[nextStream];
+			if (!stream.empty())
+			{
+				lane = { stream.data(), stream.data() + stream.size(), nextStream++, state };
+				return true;
+			}
+			results[nextStream] = { state };
+		}
+		return false;
+	};
+
+	while (laneCount < STREAM_LANES && startNextStream(lanes[laneCount]))
+	{
+		++laneCount;
+	}
+
+	const auto* nextStates = m_nextStates.data();
+	const auto inputCount = m_inputCount;
+	while (laneCount > 0)
+	{
+		for (size_t i = 0; i < laneCount;)
+		{
+			auto& lane = lanes[i];
+			const auto input = *lane.input;
+			const auto nextState = input < inputCount ? nextStates[lane.state * inputCount + input] : NO_ID;
+			if (nextState == NO_ID)
+			{
+				results[lane.stream] = { lane.state, static_cast<size_t>(lane.input - streams[lane.stream].data()) };
+			}
+			else
+			{
+				lane.state = nextState;
+				if (++lane.input != lane.end)
+				{
+					++i;
+					continue;
+				}
+				results[lane.stream] = { lane.state };
+			}
+
+			if (!startNextStream(lane))
+			{
+				lane = lanes[--laneCount];
+			}
+		}
+	}
+}
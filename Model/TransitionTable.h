@@ -0,0 +1,110 @@
+#pragma once
+
+#include "SymbolTable.h"
+
+#include <limits>
+#include <span>
+#include <vector>
+
+// Dense form of a deterministic machine: a row of next states per state, so a
+// step is a single indexed load. Moore machines fill the per-state outputs,
+// Mealy machines fill the per-transition outputs parallel to the next states.
+class TransitionTable
+{
+public:
+	using Id = SymbolTable::Id;
+
+	static constexpr Id NO_ID = SymbolTable::NO_ID;
+
+	struct RunResult
+	{
+		static constexpr size_t NOT_REJECTED = std::numeric_limits<size_t>::max();
+
+		// State after the last consumed input, pass it to the next Run to continue the stream.
+		Id state;
+		// Index of the first input without a transition, inputs from it on were not consumed.
+		size_t rejectedAt = NOT_REJECTED;
+
+		bool IsRejected() const
+		{
+			return rejectedAt != NOT_REJECTED;
+		}
+	};
+
+	TransitionTable() = default;
+
+	TransitionTable(size_t stateCount, size_t inputCount);
+
+	void SetNextState(Id state, Id input, Id nextState);
+
+	void SetStateOutput(Id state, Id output);
+
+	void SetTransitionOutput(Id state, Id input, Id output);
+
+	void SetInitialState(const Id state)
+	{
+		m_initialState = state;
+	}
+
+	Id GetNextState(const Id state, const Id input) const
+	{
+		return m_nextStates[state * m_inputCount + input];
+	}
+
+	Id GetStateOutput(const Id state) const
+	{
+		return m_stateOutputs[state];
+	}
+
+	Id GetTransitionOutput(const Id state, const Id input) const
+	{
+		return m_transitionOutputs[state * m_inputCount + input];
+	}
+
+	const Id* GetRow(const Id state) const
+	{
+		return m_nextStates.data() + state * m_inputCount;
+	}
+
+	Id GetInitialState() const
+	{
+		return m_initialState;
+	}
+
+	size_t GetStateCount() const
+	{
+		return m_stateCount;
+	}
+
+	size_t GetInputCount() const
+	{
+		return m_inputCount;
+	}
+
+	// Feeds the input ids to the machine starting in the state. outputs[i] receives the output of
+	// the state entered (Moore) or of the transition taken (Mealy) on inputs[i]. The outputs may be
+	// empty to only follow the transitions, otherwise they must be at least as long as the inputs.
+	RunResult Run(Id state, std::span<const Id> inputs, std::span<Id> outputs) const;
+
+	// Runs independent input streams from the state, results[i] is what Run returns for streams[i].
+	// Several streams advance together so the dependent table loads of one overlap with the others.
+	void RunStreams(Id state, std::span<const std::span<const Id>> streams, std::span<RunResult> results) const;
+
+	bool HasStateOutputs() const
+	{
+		return !m_stateOutputs.empty();
+	}
+
+	bool HasTransitionOutputs() const
+	{
+		return !m_transitionOutputs.empty();
+	}
+
+private:
+	size_t m_stateCount = 0;
+	size_t m_inputCount = 0;
+	Id m_initialState = NO_ID;
+	std::vector<Id> m_nextStates;
+	std::vector<Id> m_stateOutputs;
+	std::vector<Id> m_transitionOutputs;
+};
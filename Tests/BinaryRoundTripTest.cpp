@@ -0,0 +1,42 @@
+#include "../Model/MooreMachine.h"
+#include "TestSupport.h"
+
+#include <iostream>
+#include <string>
+
+int main()
+{
+	try
+	{
+		// The byte classes keep single bytes such as "q" usable as inputs of the reloaded machine.
+		MooreMachine nfa;
+		nfa.FromRegular("[a-z]+x");
+		const auto min = nfa.GetDeterministic()->GetMinimized();
+		const auto fileName = GetTempFileName("BinaryRoundTripTest.bin");
+		min->SaveToBinary(fileName);
+		MooreMachine loaded;
+		loaded.FromBinary(fileName);
+
+		Check(min->GetByteClasses().size() == Machine::BYTE_COUNT, "byte classes before the round trip");
+		Check(loaded.GetByteClasses() == min->GetByteClasses(), "byte classes after the round trip");
+		Check(loaded.GetInputId("q") != Machine::NO_ID, "input id of a byte inside a class");
+		Check(loaded.GetInputId("q") == min->GetInputId("q"), "same input id of a byte inside a class");
+		Check(loaded.GetInputId("x") == min->GetInputId("x"), "same input id of a byte with a class of its own");
+		Check(IsSameMooreLanguage(*min, loaded), "binary round trip keeps the language");
+
+		// Machines without byte classes still round trip.
+		MooreMachine plain("S0");
+		plain.AddStateOutput("S0", "0");
+		plain.AddStateOutput("S1", "1");
+		plain.AddTransition("S0", "ab", "S1");
+		plain.SaveToBinary(fileName);
+		loaded.FromBinary(fileName);
+		Check(loaded.GetByteClasses().empty(), "no byte classes for a machine without them");
+		Check(IsSameMooreLanguage(plain, loaded), "binary round trip of a machine without byte classes");
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,129 @@
+#include "../Model/MooreMachine.h"
+#include "TestSupport.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+using Id = TransitionTable::Id;
+
+// A random expression over "abc" with every operator, small enough to stay within the positions.
+std::string MakeRandomRegular(std::mt19937& random, const size_t depth)
+{
+	if (depth == 0 || random() % 4 == 0)
+	{
+		return std::string(1, "abc"[random() % 3]);
+	}
+	const auto left = MakeRandomRegular(random, depth - 1);
+	switch (random() % 7)
+	{
+	case 0:
+		return "(" + left + "|" + MakeRandomRegular(random, depth - 1) + ")";
+	case 1:
+		return "(" + left + ")*";
+	case 2:
+		return "(" + left + ")+";
+	case 3:
+		return "(" + left + ")?";
+	case 4:
+		return "(" + left + "){1,3}";
+	case 5:
+		return "(|" + left + ")";
+	default:
+		return left + MakeRandomRegular(random, depth - 1);
+	}
+}
+
+// The bit-parallel engine against the DFA of the same machine, with the text in pieces so runs
+// continue from the active positions. A rejection starts over after the rejected input.
+void CheckSameRun(const MooreMachine& nfa, const std::string& text, std::mt19937& random, const std::string& name)
+{
+	auto engine = nfa.GetBitParallel();
+	const auto dfa = nfa.GetDeterministic();
+	const auto table = dfa->Compile();
+	const auto engineInputs = GetByteInputs(nfa, text);
+	const auto dfaInputs = GetByteInputs(*dfa, text);
+
+	auto state = table.GetInitialState();
+	for (size_t begin = 0; begin < text.size();)
+	{
+		const auto length = std::min<size_t>(text.size() - begin, 1 + random() % 40);
+		std::vector<Id> engineOutputs(length);
+		std::vector<Id> dfaOutputs(length);
+		const auto rejectedAt = engine.Run(std::span(engineInputs).subspan(begin, length), engineOutputs);
+		const auto expected = table.Run(state, std::span(dfaInputs).subspan(begin, length), dfaOutputs);
+		const auto where = name + " at input " + std::to_string(begin);
+		Check(rejectedAt == expected.rejectedAt, "rejection of " + where);
+		for (size_t i = 0; i < std::min(length, rejectedAt); ++i)
+		{
+			Check(nfa.GetOutputs()[engineOutputs[i]] == dfa->GetOutputs()[dfaOutputs[i]], "output of " + where);
+		}
+		if (expected.IsRejected())
+		{
+			engine.Reset();
+			state = table.GetInitialState();
+			begin += expected.rejectedAt + 1;
+			continue;
+		}
+		state = expected.state;
+		begin += length;
+	}
+}
+
+std::string MakeRandomText(std::mt19937& random, const size_t length)
+{
+	std::string text;
+	for (size_t i = 0; i < length; ++i)
+	{
+		text += "abcx"[random() % 4];
+	}
+	return text;
+}
+} // namespace
+
+int main()
+{
+	try
+	{
+		std::mt19937 random(11);
+		// Thompson machines bring epsilon edges, Glushkov machines self loops on their positions.
+		for (size_t i = 0; i < 300; ++i)
+		{
+			const auto regular = MakeRandomRegular(random, 5);
+			for (const auto construction :
+				{ MooreMachine::RegularConstruction::THOMPSON, MooreMachine::RegularConstruction::GLUSHKOV })
+			{
+				MooreMachine nfa;
+				nfa.FromRegular(regular, construction);
+				CheckSameRun(nfa, MakeRandomText(random, 300), random, "\"" + regular + "\"");
+			}
+		}
+
+		// Each "a" is a position of its own, the start makes one more.
+		MooreMachine largest;
+		largest.FromRegular("a{255}", MooreMachine::RegularConstruction::GLUSHKOV);
+		Check(largest.GetBitParallel().GetPositionCount() == BitParallelNfa::MAX_POSITIONS, "positions of \"a{255}\"");
+		CheckSameRun(largest, std::string(600, 'a') + "b" + std::string(255, 'a'), random, "\"a{255}\"");
+
+		MooreMachine tooLarge;
+		tooLarge.FromRegular("a{256}", MooreMachine::RegularConstruction::GLUSHKOV);
+		bool isRejected = false;
+		try
+		{
+			tooLarge.GetBitParallel();
+		}
+		catch (const std::runtime_error&)
+		{
+			isRejected = true;
+		}
+		Check(isRejected, "\"a{256}\" has too many positions");
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,99 @@
+#include "../Model/MooreMachine.h"
+#include "TestSupport.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+bool IsDfaMatch(const Machine& dfa, const TransitionTable& table, const std::string& text)
+{
+	auto state = table.GetInitialState();
+	for (const auto c : text)
+	{
+		const auto input = dfa.GetInputId(std::string(1, c));
+		if (input == Machine::NO_ID || table.GetNextState(state, input) == TransitionTable::NO_ID)
+		{
+			return false;
+		}
+		state = table.GetNextState(state, input);
+	}
+	return dfa.GetOutputs()[table.GetStateOutput(state)] == "1";
+}
+
+bool IsCountingMatch(CountingAutomaton& automaton, const std::string& text)
+{
+	automaton.Reset();
+	std::vector<CountingAutomaton::Id> inputs;
+	for (const auto c : text)
+	{
+		inputs.push_back(automaton.GetByteClasses()[static_cast<unsigned char>(c)]);
+	}
+	return automaton.Run(inputs, {}) == CountingAutomaton::NOT_REJECTED && automaton.IsAccepting();
+}
+
+// The counting automaton, forced by an unroll limit of zero, accepts the same words as the DFA.
+void CheckSameLanguage(const std::string& regular, const size_t expectedCounters)
+{
+	MooreMachine counted;
+	auto automaton = counted.FromRegularWithCounters(regular, 0);
+	Check(automaton.has_value(), "counting automaton of \"" + regular + "\"");
+	Check(automaton->GetCounterCount() == expectedCounters, "counters of \"" + regular + "\"");
+
+	MooreMachine nfa;
+	nfa.FromRegular(regular, MooreMachine::RegularConstruction::GLUSHKOV);
+	const auto dfa = nfa.GetDeterministic()->GetMinimized();
+	const auto table = dfa->Compile();
+
+	const std::string alphabet = "abcx";
+	std::vector<std::string> words = { "" };
+	for (size_t begin = 0, length = 0; length < 7; ++length)
+	{
+		const auto end = words.size();
+		for (auto i = begin; i < end; ++i)
+		{
+			for (const auto c : alphabet)
+			{
+				words.push_back(words[i] + c);
+			}
+		}
+		begin = end;
+	}
+	for (const auto& word : words)
+	{
+		Check(IsCountingMatch(*automaton, word) == IsDfaMatch(*dfa, table, word),
+			"\"" + regular + "\" on \"" + word + "\"");
+	}
+}
+} // namespace
+
+int main()
+{
+	try
+	{
+		CheckSameLanguage("[ab]{3}", 1);
+		CheckSameLanguage("a{2,4}b", 1);
+		CheckSameLanguage("(a|b){2,}c", 1);
+		CheckSameLanguage("([ab]{2}c)*", 1);
+		CheckSameLanguage("([ab]{2})*", 1);
+		CheckSameLanguage("a{0,3}", 1);
+		CheckSameLanguage("(ab){2}[ab]{1,2}", 1);
+		CheckSameLanguage("x[ab]{2,3}|a{3}b?", 2);
+		CheckSameLanguage("(a{2}c){2}", 2);
+		CheckSameLanguage("a*b+c?", 0);
+
+		// Small expressions are built as machines, large ones only with counters.
+		MooreMachine machine;
+		Check(!machine.FromRegularWithCounters("[ab]{3}x").has_value(), "no counters below the unroll limit");
+		Check(!machine.GetStates().empty(), "machine below the unroll limit");
+		const auto automaton = machine.FromRegularWithCounters("[ab]{100000}x");
+		Check(automaton.has_value() && automaton->GetPositionCount() == 3, "one position per counted repetition");
+		Check(machine.GetStates().empty(), "no machine with counters");
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,45 @@
+#include "../Model/MooreMachine.h"
+#include "TestSupport.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Inputs with ',', '"' and '\\' in their names must come back from DOT as they were, with and
+// without merged parallel edges.
+void CheckRoundTrip(const std::string& regular)
+{
+	MooreMachine nfa;
+	nfa.FromRegular(regular);
+	const auto min = nfa.GetDeterministic()->GetMinimized();
+
+	for (const auto mergeParallelEdges : { false, true })
+	{
+		const auto fileName = GetTempFileName("DotRoundTripTest.dot");
+		min->SaveToDot(fileName, { mergeParallelEdges });
+		MooreMachine loaded;
+		loaded.FromDot(fileName);
+		Check(IsSameMooreLanguage(*min, loaded), "DOT round trip of \"" + regular + "\""
+				+ (mergeParallelEdges ? " with merged edges" : ""));
+	}
+}
+} // namespace
+
+int main()
+{
+	try
+	{
+		const std::vector<std::string> regulars = { "a,b", "[,x]y", "\"", "a\\\\b", "[,\"\\\\]+x|y,", "(a|b|c)*,d" };
+		for (const auto& regular : regulars)
+		{
+			CheckRoundTrip(regular);
+		}
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,76 @@
+#include "../Model/MooreMachine.h"
+#include "TestSupport.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+using Id = TransitionTable::Id;
+
+// The lazy DFA, with a cache small enough to be flushed several times, against the full DFA. The
+// text runs in pieces of random length, so runs continue from states rebuilt by a flush.
+void CheckSameRun(const std::string& regular, const std::string& alphabet, std::mt19937& random)
+{
+	MooreMachine nfa;
+	nfa.FromRegular(regular);
+	const auto dfa = nfa.GetDeterministic();
+	const auto table = dfa->Compile();
+	auto lazy = nfa.GetLazyDeterministic(1024);
+
+	std::string text;
+	for (size_t i = 0; i < 20000; ++i)
+	{
+		text += alphabet[random() % alphabet.size()];
+	}
+	const auto lazyInputs = GetByteInputs(nfa, text);
+	const auto dfaInputs = GetByteInputs(*dfa, text);
+
+	lazy.Reset();
+	auto state = table.GetInitialState();
+	for (size_t begin = 0; begin < text.size();)
+	{
+		const auto length = std::min<size_t>(text.size() - begin, 1 + random() % 500);
+		std::vector<Id> lazyOutputs(length);
+		std::vector<Id> dfaOutputs(length);
+		const auto rejectedAt = lazy.Run(std::span(lazyInputs).subspan(begin, length), lazyOutputs);
+		const auto expected = table.Run(state, std::span(dfaInputs).subspan(begin, length), dfaOutputs);
+		const auto name = "\"" + regular + "\" at input " + std::to_string(begin);
+		Check(rejectedAt == expected.rejectedAt, "rejection of " + name);
+		for (size_t i = 0; i < std::min(length, rejectedAt); ++i)
+		{
+			Check(nfa.GetOutputs()[lazyOutputs[i]] == dfa->GetOutputs()[dfaOutputs[i]], "output of " + name);
+		}
+		if (expected.IsRejected())
+		{
+			// A rejection leaves the state before it, the text goes on from the start.
+			lazy.Reset();
+			state = table.GetInitialState();
+			begin += expected.rejectedAt + 1;
+			continue;
+		}
+		state = expected.state;
+		begin += length;
+	}
+	Check(lazy.GetStatistics().flushes >= 3, "cache flushes for \"" + regular + "\"");
+}
+} // namespace
+
+int main()
+{
+	try
+	{
+		std::mt19937 random(7);
+		CheckSameRun("(a|b)*a(a|b){8}", "ab", random);
+		CheckSameRun("(a|b|c)*(abc|acb)(a|b){4}c*", "abc", random);
+		// Missing transitions on a rare "c" and the byte "x" outside the expression reject.
+		CheckSameRun("((a|b)*a(a|b){6}c)*", std::string(30, 'a') + std::string(30, 'b') + "cx", random);
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,155 @@
+#include "../Model/MachineExecutor.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+using Id = TransitionTable::Id;
+
+// Each transition is missing with the given probability. Mealy tables get transition outputs,
+// Moore tables state outputs.
+TransitionTable MakeRandomTable(
+	std::mt19937& random, const size_t stateCount, const size_t inputCount, const double missing, const bool isMealy)
+{
+	TransitionTable table(stateCount, inputCount);
+	std::bernoulli_distribution isMissing(missing);
+	for (Id state = 0; state < stateCount; ++state)
+	{
+		if (!isMealy)
+		{
+			table.SetStateOutput(state, static_cast<Id>(random() % 3));
+		}
+		for (Id input = 0; input < inputCount; ++input)
+		{
+			if (isMissing(random))
+			{
+				continue;
+			}
+			table.SetNextState(state, input, static_cast<Id>(random() % stateCount));
+			if (isMealy)
+			{
+				table.SetTransitionOutput(state, input, static_cast<Id>(random() % 3));
+			}
+		}
+	}
+	table.SetInitialState(0);
+	return table;
+}
+
+// Known inputs, with an unknown one, past the input count or NO_ID, at the given rate.
+std::vector<Id> MakeRandomInputs(std::mt19937& random, const size_t length, const size_t inputCount, const double unknown)
+{
+	std::bernoulli_distribution isUnknown(unknown);
+	std::vector<Id> inputs(length);
+	for (auto& input : inputs)
+	{
+		input = isUnknown(random) ? (random() % 2 == 0 ? static_cast<Id>(inputCount) : TransitionTable::NO_ID)
+								  : static_cast<Id>(random() % inputCount);
+	}
+	return inputs;
+}
+
+// The results must be equal, and so must the outputs up to the rejection.
+void CheckSameRun(const TransitionTable::RunResult& expected, const std::vector<Id>& expectedOutputs,
+	const TransitionTable::RunResult& result, const std::vector<Id>& outputs, const std::string& name)
+{
+	Check(result.state == expected.state && result.rejectedAt == expected.rejectedAt, "result of " + name);
+	const auto end = std::min(expected.rejectedAt, expectedOutputs.size());
+	Check(std::equal(outputs.begin(), outputs.begin() + static_cast<std::ptrdiff_t>(end), expectedOutputs.begin()),
+		"outputs of " + name);
+}
+
+// The shuffle engine against the table on machines of up to 16 states, with alphabets below, at and
+// above the 16 inputs of the pair rows, inputs of odd lengths and unknown inputs.
+void CheckShuffles(std::mt19937& random)
+{
+	for (size_t i = 0; i < 2000; ++i)
+	{
+		const auto stateCount = 1 + random() % MachineExecutor::MAX_SHUFFLE_STATES;
+		const std::vector<size_t> inputCounts = { 1 + random() % 15, 16, 17 + random() % 8 };
+		const auto inputCount = inputCounts[i % inputCounts.size()];
+		const auto missing = i % 3 == 0 ? 0.0 : 0.01;
+		const auto isMealy = i % 2 == 0;
+		const auto table = MakeRandomTable(random, stateCount, inputCount, missing, isMealy);
+		const MachineExecutor executor(table);
+
+		const auto inputs = MakeRandomInputs(random, random() % 300, inputCount, i % 4 == 0 ? 0.003 : 0.0);
+		const auto start = static_cast<Id>(random() % stateCount);
+		const auto name = "machine " + std::to_string(i) + " with " + std::to_string(stateCount) + " states and "
+			+ std::to_string(inputCount) + " inputs";
+
+		CheckSameRun(table.Run(start, inputs, {}), {}, executor.Run(start, inputs, {}), {}, name);
+		std::vector<Id> expectedOutputs(inputs.size());
+		std::vector<Id> outputs(inputs.size());
+		const auto expected = table.Run(start, inputs, expectedOutputs);
+		CheckSameRun(expected, expectedOutputs, executor.Run(start, inputs, outputs), outputs, name + " with outputs");
+	}
+}
+
+// RunParallel against the serial run for lengths that do not split evenly into chunks, fewer inputs
+// than threads, and an input without transitions placed in the middle of a later chunk.
+void CheckParallel(std::mt19937& random)
+{
+	// Chunks take at least 1 << 16 inputs, so only the long inputs are split.
+	const std::vector<size_t> lengths = { 0, 10, 3 * (1 << 16) + 7, 16 * (1 << 16) + 13 };
+	for (const auto stateCount : { 5, 16, 100, 300 })
+	{
+		for (const auto isMealy : { false, true })
+		{
+			// The last input has no transitions, the inputs read it once if at all.
+			const size_t inputCount = 4;
+			auto table = MakeRandomTable(random, stateCount, inputCount, 0.0, isMealy);
+			for (Id state = 0; state < stateCount; ++state)
+			{
+				table.SetNextState(state, inputCount - 1, TransitionTable::NO_ID);
+			}
+			const MachineExecutor executor(table);
+
+			for (const auto length : lengths)
+			{
+				for (const auto isRejecting : { false, true })
+				{
+					auto inputs = MakeRandomInputs(random, length, inputCount - 1, 0.0);
+					if (isRejecting && length > 0)
+					{
+						inputs[length * 5 / 8] = static_cast<Id>(inputCount - 1);
+					}
+					const auto start = static_cast<Id>(random() % stateCount);
+					std::vector<Id> expectedOutputs(length);
+					const auto expected = table.Run(start, inputs, expectedOutputs);
+					for (const auto threadCount : { 1, 2, 7, 16 })
+					{
+						const auto name = "parallel run of " + std::to_string(length) + " inputs on "
+							+ std::to_string(threadCount) + " threads, " + std::to_string(stateCount) + " states"
+							+ (isMealy ? ", Mealy" : "") + (isRejecting ? ", rejecting" : "");
+						CheckSameRun(expected, {}, executor.RunParallel(start, inputs, {}, threadCount), {}, name);
+						std::vector<Id> outputs(length);
+						CheckSameRun(expected, expectedOutputs, executor.RunParallel(start, inputs, outputs, threadCount),
+							outputs, name + " with outputs");
+					}
+				}
+			}
+		}
+	}
+}
+} // namespace
+
+int main()
+{
+	try
+	{
+		std::mt19937 random(5);
+		CheckShuffles(random);
+		CheckParallel(random);
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+}
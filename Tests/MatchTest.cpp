@@ -0,0 +1,68 @@
+#include "TestSupport.h"
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::string ReadCommandOutput(const std::string& command)
+{
+	const auto pipe = popen(command.c_str(), "r");
+	if (!pipe)
+	{
+		throw std::runtime_error("Cannot run " + command);
+	}
+	std::string output;
+	std::array<char, 256> buffer{};
+	while (const auto size = std::fread(buffer.data(), 1, buffer.size(), pipe))
+	{
+		output.append(buffer.data(), size);
+	}
+	pclose(pipe);
+	return output;
+}
+
+// The patterns have no single quotes, so quoting them for the shell needs no escapes.
+void CheckSameCount(const std::string& match, const std::string& pattern, const std::string& fileName)
+{
+	const auto count = ReadCommandOutput("\"" + match + "\" --count '" + pattern + "' " + fileName);
+	const auto expected = ReadCommandOutput("grep -E -c '" + pattern + "' " + fileName);
+	Check(!expected.empty() && count == expected,
+		"Match --count '" + pattern + "' gives " + count + " where grep -c gives " + expected);
+}
+} // namespace
+
+// Takes the path of the Match executable and compares its counts with those of grep.
+int main(int argc, char* argv[])
+{
+	try
+	{
+		if (argc != 2)
+		{
+			throw std::invalid_argument("Usage: MatchTest <Match executable>");
+		}
+
+		const auto fileName = GetTempFileName("MatchTest.txt");
+		std::ofstream(fileName) << "int main()\n"
+								   "intmain\n"
+								   "the quick fox\n"
+								   "th dog\n"
+								   "for (int i = 0; i < n; ++i)\n"
+								   "for each\n"
+								   "  int  main\n"
+								   "other\n";
+
+		CheckSameCount(argv[1], "int main", fileName);
+		CheckSameCount(argv[1], "the", fileName);
+		CheckSameCount(argv[1], "for \\(", fileName);
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,136 @@
+#include "../Model/MealyMachine.h"
+#include "../Model/MooreMachine.h"
+#include "TestSupport.h"
+
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace
+{
+constexpr MinimizeOptions MOORE_REFINEMENT = { MinimizationAlgorithm::MOORE_REFINEMENT };
+constexpr MinimizeOptions HOPCROFT = { MinimizationAlgorithm::HOPCROFT };
+
+// Both algorithms give the same number of states and machines equivalent to the input.
+void CheckMinimized(const Machine& machine, const bool isMealy, const std::string& name)
+{
+	const auto reference = machine.GetMinimized(MOORE_REFINEMENT);
+	const auto hopcroft = machine.GetMinimized(HOPCROFT);
+	Check(hopcroft->GetStates().size() == reference->GetStates().size(), "state count of " + name);
+	const auto isSame = isMealy ? IsSameMealyLanguage : IsSameMooreLanguage;
+	Check(isSame(*hopcroft, *reference), "Hopcroft and Moore refinement machines of " + name);
+	Check(isSame(*hopcroft, machine), "Hopcroft machine and " + name);
+}
+
+std::string GetStateName(const size_t state)
+{
+	return "S" + std::to_string(state);
+}
+
+// A partial DFA, each transition is missing with the given probability. Few outputs and inputs
+// leave many equivalent states to merge.
+MooreMachine MakeRandomMoore(std::mt19937& random, const size_t stateCount, const size_t inputCount, const double missing)
+{
+	MooreMachine moore(GetStateName(0));
+	std::uniform_int_distribution<size_t> states(0, stateCount - 1);
+	std::bernoulli_distribution isMissing(missing);
+	for (size_t state = 0; state < stateCount; ++state)
+	{
+		moore.AddStateOutput(GetStateName(state), "out" + std::to_string(random() % 2));
+	}
+	for (size_t state = 0; state < stateCount; ++state)
+	{
+		for (size_t input = 0; input < inputCount; ++input)
+		{
+			if (!isMissing(random))
+			{
+				moore.AddTransition(GetStateName(state), "x" + std::to_string(input), GetStateName(states(random)));
+			}
+		}
+	}
+	return moore;
+}
+
+MealyMachine MakeRandomMealy(std::mt19937& random, const size_t stateCount, const size_t inputCount, const double missing)
+{
+	MealyMachine mealy(GetStateName(0));
+	std::uniform_int_distribution<size_t> states(0, stateCount - 1);
+	std::bernoulli_distribution isMissing(missing);
+	for (size_t state = 0; state < stateCount; ++state)
+	{
+		for (size_t input = 0; input < inputCount; ++input)
+		{
+			if (!isMissing(random))
+			{
+				mealy.AddTransition(GetStateName(state), "x" + std::to_string(input), GetStateName(states(random)),
+					"y" + std::to_string(random() % 2));
+			}
+		}
+	}
+	return mealy;
+}
+
+// A chain whose states differ only by their distance to the last, the case refinement is slowest on.
+MooreMachine MakeChain(const size_t length)
+{
+	MooreMachine moore(GetStateName(0));
+	for (size_t state = 0; state < length; ++state)
+	{
+		moore.AddStateOutput(GetStateName(state), state + 1 == length ? "out1" : "out0");
+		if (state + 1 < length)
+		{
+			moore.AddTransition(GetStateName(state), "x0", GetStateName(state + 1));
+		}
+		moore.AddTransition(GetStateName(state), "x1", GetStateName(0));
+	}
+	return moore;
+}
+} // namespace
+
+// Takes the directory of the bundled machines, Minimize/input.
+int main(int argc, char* argv[])
+{
+	try
+	{
+		if (argc != 2)
+		{
+			throw std::invalid_argument("Usage: MinimizeTest <directory of DOT machines>");
+		}
+
+		for (const auto& entry : std::filesystem::directory_iterator(argv[1]))
+		{
+			// The bundled files name the kind of machine they hold.
+			const auto fileName = entry.path().string();
+			if (entry.path().filename().string().find("moore") != std::string::npos)
+			{
+				MooreMachine moore;
+				moore.FromDot(fileName);
+				CheckMinimized(moore, false, fileName);
+			}
+			else
+			{
+				MealyMachine mealy;
+				mealy.FromDot(fileName);
+				CheckMinimized(mealy, true, fileName);
+			}
+		}
+
+		std::mt19937 random(3);
+		for (size_t i = 0; i < 200; ++i)
+		{
+			const auto stateCount = 1 + random() % 40;
+			const auto inputCount = 1 + random() % 4;
+			const auto missing = i % 2 == 0 ? 0.0 : 0.3;
+			const auto name = "random machine " + std::to_string(i);
+			CheckMinimized(MakeRandomMoore(random, stateCount, inputCount, missing), false, "Moore " + name);
+			CheckMinimized(MakeRandomMealy(random, stateCount, inputCount, missing), true, "Mealy " + name);
+		}
+		CheckMinimized(MakeChain(500), false, "a chain of 500 states");
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+}
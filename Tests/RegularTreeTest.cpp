@@ -0,0 +1,133 @@
+#include "../Model/MooreMachine.h"
+#include "../Model/RegularTree.h"
+#include "TestSupport.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+void CheckSimplifiesTo(const std::string& regular, const std::string& expected)
+{
+	RegularTree tree;
+	Check(tree.Simplify(tree.Parse(regular)) == tree.Simplify(tree.Parse(expected)),
+		"\"" + regular + "\" simplifies to \"" + expected + "\"");
+}
+
+void CheckAccepts(const std::string& regular, const std::string& text, const bool isAccepted)
+{
+	MooreMachine nfa;
+	nfa.FromRegular(regular);
+	Check(IsAcceptedText(*nfa.GetDeterministic(), text) == isAccepted,
+		"\"" + regular + "\" " + (isAccepted ? "accepts" : "rejects") + " \"" + text + "\"");
+}
+
+bool IsRejectedSyntax(const std::string& regular)
+{
+	try
+	{
+		MooreMachine nfa;
+		nfa.FromRegular(regular);
+	}
+	catch (const std::runtime_error&)
+	{
+		return true;
+	}
+	return false;
+}
+
+// Every construction starts from the parsed tree and gives the same minimal machine. DERIVATIVES
+// builds a DFA directly, which must already accept the same words before minimization. Its
+// inputs are not merged as far as in the minimal machine, so the words are compared by bytes.
+void CheckSameConstructions(const std::string& regular)
+{
+	const auto build = [&regular](const MooreMachine::RegularConstruction construction) {
+		MooreMachine machine;
+		machine.FromRegular(regular, construction);
+		return machine.GetDeterministic()->GetMinimized();
+	};
+	const auto thompson = build(MooreMachine::RegularConstruction::THOMPSON);
+	Check(IsSameMooreLanguage(*thompson, *build(MooreMachine::RegularConstruction::GLUSHKOV)),
+		"Glushkov and Thompson machines of \"" + regular + "\"");
+	Check(IsSameMooreLanguage(*thompson, *build(MooreMachine::RegularConstruction::DERIVATIVES)),
+		"derivative and Thompson machines of \"" + regular + "\"");
+
+	MooreMachine derivatives;
+	derivatives.FromRegular(regular, MooreMachine::RegularConstruction::DERIVATIVES);
+	Check(derivatives.IsDeterministic(), "derivative DFA of \"" + regular + "\"");
+	Check(derivatives.GetStates().size() >= thompson->GetStates().size(), "derivative states of \"" + regular + "\"");
+	std::vector<std::string> words = { "" };
+	for (size_t i = 0; i < words.size() && words[i].size() < 3; ++i)
+	{
+		for (const auto c : std::string("abcdexz"))
+		{
+			words.push_back(words[i] + c);
+		}
+	}
+	for (const auto& word : words)
+	{
+		Check(IsAcceptedText(derivatives, word) == IsAcceptedText(*thompson, word),
+			"derivative DFA of \"" + regular + "\" on \"" + word + "\"");
+	}
+}
+} // namespace
+
+int main()
+{
+	try
+	{
+		RegularTree tree;
+		const auto parsed = tree.Parse("((a*(a|b)*a) | b* (c|b)* b | c* (c|a)* c)");
+		Check(tree.GetNodeCount(tree.Simplify(parsed)) < tree.GetNodeCount(parsed), "fewer nodes after simplification");
+
+		CheckSimplifiesTo("(a*)*", "a*");
+		CheckSimplifiesTo("(|a)*", "a*");
+		CheckSimplifiesTo("a*a*", "a*");
+		CheckSimplifiesTo("a|b|a", "[ab]");
+
+		// "e" is always the letter, an empty alternative is epsilon.
+		CheckAccepts("the", "the", true);
+		CheckAccepts("the", "th", false);
+		CheckAccepts("e", "", false);
+		CheckAccepts("(|a)b", "b", true);
+		CheckAccepts("(|a)b", "ab", true);
+		CheckAccepts("a()b", "ab", true);
+
+		// A backslash makes metacharacters and spaces literal, in classes too.
+		CheckAccepts("\\(\\)\\|\\[\\]\\*\\+\\?\\{\\}\\\\", "()|[]*+?{}\\", true);
+		CheckAccepts("for \\(", "for(", true);
+		CheckAccepts("int\\ main", "int main", true);
+		CheckAccepts("int\\ main", "intmain", false);
+		CheckAccepts("[\\]\\-a]+", "]-a", true);
+		CheckAccepts("[\\]\\-a]+", "b", false);
+		CheckAccepts("[\\ x]", " ", true);
+		Check(IsRejectedSyntax("a\\"), "trailing backslash rejected");
+		Check(IsRejectedSyntax("[a\\]"), "unclosed class with an escaped bracket rejected");
+
+		// Nested stars, bounded repetitions and classes, alone and together.
+		const std::vector<std::string> regulars = {
+			"((a*(a|b)*a) | b* (c|b)* b | c* (c|a)* c)",
+			"((a*b*)*c*)*",
+			"(a*|b)*a(b*)*",
+			"((ab)*|(ba)*)*b",
+			"(ab|c){2,4}",
+			"a{0,3}b{2,}c{1}",
+			"((a|b){1,2}c){2,3}",
+			"[a-c]{2,3}(x|y)+z?",
+			"(ab|ac)*[b-d]",
+			"[a-c]+[b-d]?[x-z]{1,2}",
+			"([a-c]*d){1,3}|e*",
+			"(|[ab])([a-z]{2})*",
+		};
+		for (const auto& regular : regulars)
+		{
+			CheckSameConstructions(regular);
+		}
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../Model/Machine.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+inline void Check(const bool condition, const std::string& message)
+{
+	if (!condition)
+	{
+		throw std::runtime_error("Check failed: " + message);
+	}
+}
+
+inline std::string GetTempFileName(const std::string& name)
+{
+	return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Whether two deterministic Moore machines have the same inputs by name and give the same outputs,
+// and miss the same transitions, on every sequence of inputs.
+inline bool IsSameMooreLanguage(const Machine& left, const Machine& right)
+{
+	auto leftInputs = left.GetInputs();
+	auto rightInputs = right.GetInputs();
+	std::ranges::sort(leftInputs);
+	std::ranges::sort(rightInputs);
+	if (leftInputs != rightInputs)
+	{
+		return false;
+	}
+
+	const auto leftTable = left.Compile();
+	const auto rightTable = right.Compile();
+	const auto getOutput = [](const Machine& machine, const TransitionTable& table, const TransitionTable::Id state) {
+		return machine.GetOutputs()[table.GetStateOutput(state)];
+	};
+
+	using Pair = std::pair<TransitionTable::Id, TransitionTable::Id>;
+	std::vector<Pair> pending = { { leftTable.GetInitialState(), rightTable.GetInitialState() } };
+	std::vector<Pair> seen = pending;
+	while (!pending.empty())
+	{
+		const auto [leftState, rightState] = pending.back();
+		pending.pop_back();
+		if (getOutput(left, leftTable, leftState) != getOutput(right, rightTable, rightState))
+		{
+			return false;
+		}
+		for (const auto& input : leftInputs)
+		{
+			const auto leftNext = leftTable.GetNextState(leftState, left.GetInputId(input));
+			const auto rightNext = rightTable.GetNextState(rightState, right.GetInputId(input));
+			if ((leftNext == TransitionTable::NO_ID) != (rightNext == TransitionTable::NO_ID))
+			{
+				return false;
+			}
+			if (leftNext != TransitionTable::NO_ID && std::ranges::find(seen, Pair{ leftNext, rightNext }) == seen.end())
+			{
+				seen.emplace_back(leftNext, rightNext);
+				pending.emplace_back(leftNext, rightNext);
+			}
+		}
+	}
+	return true;
+}
+
+// Whether two deterministic Mealy machines have the same inputs by name and give the same
+// transition outputs, and miss the same transitions, on every sequence of inputs.
+inline bool IsSameMealyLanguage(const Machine& left, const Machine& right)
+{
+	auto leftInputs = left.GetInputs();
+	auto rightInputs = right.GetInputs();
+	std::ranges::sort(leftInputs);
+	std::ranges::sort(rightInputs);
+	if (leftInputs != rightInputs)
+	{
+		return false;
+	}
+
+	const auto leftTable = left.Compile();
+	const auto rightTable = right.Compile();
+	using Pair = std::pair<TransitionTable::Id, TransitionTable::Id>;
+	std::vector<Pair> pending = { { leftTable.GetInitialState(), rightTable.GetInitialState() } };
+	std::vector<Pair> seen = pending;
+	while (!pending.empty())
+	{
+		const auto [leftState, rightState] = pending.back();
+		pending.pop_back();
+		for (const auto& input : leftInputs)
+		{
+			const auto leftInput = left.GetInputId(input);
+			const auto rightInput = right.GetInputId(input);
+			const auto leftNext = leftTable.GetNextState(leftState, leftInput);
+			const auto rightNext = rightTable.GetNextState(rightState, rightInput);
+			if ((leftNext == TransitionTable::NO_ID) != (rightNext == TransitionTable::NO_ID))
+			{
+				return false;
+			}
+			if (leftNext == TransitionTable::NO_ID)
+			{
+				continue;
+			}
+			if (left.GetOutputs()[leftTable.GetTransitionOutput(leftState, leftInput)]
+				!= right.GetOutputs()[rightTable.GetTransitionOutput(rightState, rightInput)])
+			{
+				return false;
+			}
+			if (std::ranges::find(seen, Pair{ leftNext, rightNext }) == seen.end())
+			{
+				seen.emplace_back(leftNext, rightNext);
+				pending.emplace_back(leftNext, rightNext);
+			}
+		}
+	}
+	return true;
+}
+
+// Input ids of the bytes of the text for a machine built from a regular expression.
+inline std::vector<TransitionTable::Id> GetByteInputs(const Machine& machine, const std::string_view text)
+{
+	std::vector<TransitionTable::Id> inputs;
+	for (const auto c : text)
+	{
+		inputs.push_back(machine.GetByteClasses()[static_cast<unsigned char>(c)]);
+	}
+	return inputs;
+}
+
+// Whether a deterministic machine built from a regular expression outputs "1" after the bytes of the text.
+inline bool IsAcceptedText(const Machine& dfa, const std::string_view text)
+{
+	const auto table = dfa.Compile();
+	const auto& byteClasses = dfa.GetByteClasses();
+	auto state = table.GetInitialState();
+	for (const auto c : text)
+	{
+		const auto input = byteClasses[static_cast<unsigned char>(c)];
+		if (input == Machine::NO_ID || table.GetNextState(state, input) == TransitionTable::NO_ID)
+		{
+			return false;
+		}
+		state = table.GetNextState(state, input);
+	}
+	return dfa.GetOutputs()[table.GetStateOutput(state)] == "1";
+}